@@ -0,0 +1,345 @@
+/*
+
+  Benchmark for the area assembly.
+
+  Runs the two-pass area build with the MultipolygonCollector and the
+  Assembler over an OSM file, or over synthetic data of one of these
+  kinds:
+
+  ring N        One closed way with N segments.
+  inner N M     A multipolygon with an outer ring of N segments and M
+                small inner rings.
+  touching M    A multipolygon with M square outer rings in a row,
+                touching each other at their corners.
+  coastline N   A multipolygon with one long zigzag ring of N segments
+                split into ways of 100 segments each.
+
+  Reports the number of areas produced and failed, timing percentiles
+  over all assembled objects, the slowest objects, and the memory
+  high-water mark of the process.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_collector.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/visitor.hpp>
+
+typedef osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
+typedef osmium::handler::NodeLocationsForWays<index_type> location_handler_type;
+
+struct Timing {
+    std::chrono::nanoseconds time;
+    char type;
+    osmium::object_id_type id;
+};
+
+static std::vector<Timing> timings;
+static size_t areas_produced = 0;
+static size_t areas_failed = 0;
+
+/**
+ * Wraps the Assembler and records the time it takes for each object.
+ */
+class TimedAssembler {
+
+    osmium::area::Assembler m_assembler;
+
+    // The assembler always adds an area, if it fails the area has no rings.
+    static void count_areas(const osmium::memory::Buffer& out_buffer, size_t offset) {
+        for (auto it = out_buffer.get_iterator<osmium::Area>(offset); it != out_buffer.cend<osmium::Area>(); ++it) {
+            if (it->num_rings().first > 0) {
+                ++areas_produced;
+            } else {
+                ++areas_failed;
+            }
+        }
+    }
+
+public:
+
+    typedef osmium::area::Assembler::config_type config_type;
+
+    explicit TimedAssembler(const config_type& config) :
+        m_assembler(config) {
+    }
+
+    void operator()(const osmium::Way& way, osmium::memory::Buffer& out_buffer) {
+        const size_t offset = out_buffer.committed();
+        const auto start = std::chrono::steady_clock::now();
+        m_assembler(way, out_buffer);
+        timings.push_back(Timing{std::chrono::steady_clock::now() - start, 'w', way.id()});
+        count_areas(out_buffer, offset);
+    }
+
+    void operator()(const osmium::Relation& relation, const std::vector<size_t>& members, const osmium::memory::Buffer& in_buffer, osmium::memory::Buffer& out_buffer) {
+        const size_t offset = out_buffer.committed();
+        const auto start = std::chrono::steady_clock::now();
+        m_assembler(relation, members, in_buffer, out_buffer);
+        timings.push_back(Timing{std::chrono::steady_clock::now() - start, 'r', relation.id()});
+        count_areas(out_buffer, offset);
+    }
+
+}; // class TimedAssembler
+
+typedef osmium::area::MultipolygonCollector<TimedAssembler> collector_type;
+
+class SyntheticData {
+
+    osmium::memory::Buffer m_relations{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::memory::Buffer m_ways{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::object_id_type m_next_node_id = 1;
+    osmium::object_id_type m_next_way_id = 1;
+    std::vector<std::pair<osmium::object_id_type, const char*>> m_members;
+
+public:
+
+    // Add a way with the given locations, the first and last node are
+    // the same if the locations are.
+    void add_way(const std::vector<osmium::Location>& locations, const char* role, bool tagged = false) {
+        const osmium::object_id_type first_node_id = m_next_node_id;
+        {
+            osmium::builder::WayBuilder builder(m_ways);
+            builder.object().set_id(m_next_way_id);
+            builder.add_user("");
+            {
+                osmium::builder::WayNodeListBuilder wnl_builder(m_ways, &builder);
+                for (size_t i = 0; i < locations.size(); ++i) {
+                    if (i + 1 == locations.size() && locations.size() > 1 && locations.front() == locations.back()) {
+                        wnl_builder.add_node_ref(first_node_id, locations[i]);
+                    } else {
+                        wnl_builder.add_node_ref(m_next_node_id++, locations[i]);
+                    }
+                }
+            }
+            if (tagged) {
+                osmium::builder::TagListBuilder tl_builder(m_ways, &builder);
+                tl_builder.add_tag("building", "yes");
+            }
+        }
+        m_ways.commit();
+        m_members.emplace_back(m_next_way_id++, role);
+    }
+
+    // Add a way continuing the last one, starting with its last node.
+    void add_connected_ways(const std::vector<osmium::Location>& locations, size_t segments_per_way) {
+        const osmium::object_id_type first_node_id = m_next_node_id;
+        osmium::object_id_type node_id = m_next_node_id;
+        for (size_t start = 0; start + 1 < locations.size(); start += segments_per_way) {
+            const size_t end = std::min(start + segments_per_way, locations.size() - 1);
+            {
+                osmium::builder::WayBuilder builder(m_ways);
+                builder.object().set_id(m_next_way_id);
+                builder.add_user("");
+                osmium::builder::WayNodeListBuilder wnl_builder(m_ways, &builder);
+                for (size_t i = start; i <= end; ++i) {
+                    const bool closing = i + 1 == locations.size();
+                    wnl_builder.add_node_ref(closing ? first_node_id : node_id + static_cast<osmium::object_id_type>(i), locations[i]);
+                }
+            }
+            m_ways.commit();
+            m_members.emplace_back(m_next_way_id++, "outer");
+        }
+        m_next_node_id += static_cast<osmium::object_id_type>(locations.size());
+    }
+
+    // Add a multipolygon relation with all ways added since the last one.
+    void add_relation() {
+        {
+            osmium::builder::RelationBuilder builder(m_relations);
+            builder.object().set_id(1);
+            builder.add_user("");
+            {
+                osmium::builder::RelationMemberListBuilder rml_builder(m_relations, &builder);
+                for (const auto& member : m_members) {
+                    rml_builder.add_member(osmium::item_type::way, member.first, member.second);
+                }
+            }
+            osmium::builder::TagListBuilder tl_builder(m_relations, &builder);
+            tl_builder.add_tag("type", "multipolygon");
+            tl_builder.add_tag("natural", "water");
+        }
+        m_relations.commit();
+        m_members.clear();
+    }
+
+    void run(collector_type& collector) {
+        collector.read_relations(m_relations.begin(), m_relations.end());
+        osmium::apply(m_ways, collector.handler());
+    }
+
+}; // class SyntheticData
+
+static std::vector<osmium::Location> square(int32_t x, int32_t y, int32_t size) {
+    return {
+        osmium::Location{x, y},
+        osmium::Location{x + size, y},
+        osmium::Location{x + size, y + size},
+        osmium::Location{x, y + size},
+        osmium::Location{x, y}
+    };
+}
+
+// A closed ring with num_segments segments around a circle-like shape.
+static std::vector<osmium::Location> ring(int32_t x, int32_t y, int32_t size, size_t num_segments) {
+    std::vector<osmium::Location> locations;
+    const size_t n = std::max(num_segments, size_t(3));
+    for (size_t i = 0; i < n; ++i) {
+        // a diamond with n points evenly spread over its four sides
+        const int64_t pos = static_cast<int64_t>(i) * 4 * size / static_cast<int64_t>(n);
+        const int32_t side = static_cast<int32_t>(pos / size);
+        const int32_t d = static_cast<int32_t>(pos % size);
+        switch (side) {
+            case 0: locations.emplace_back(x + d, y - size + d); break;
+            case 1: locations.emplace_back(x + size - d, y + d); break;
+            case 2: locations.emplace_back(x - d, y + size - d); break;
+            default: locations.emplace_back(x - size + d, y - d); break;
+        }
+    }
+    locations.push_back(locations.front());
+    return locations;
+}
+
+static bool run_synthetic(const std::vector<std::string>& args, collector_type& collector) {
+    SyntheticData data;
+    const auto arg = [&args](size_t n) {
+        return n < args.size() ? std::strtoul(args[n].c_str(), nullptr, 10) : 0;
+    };
+
+    if (args.size() == 2 && args[0] == "ring") {
+        data.add_way(ring(0, 0, 100000000, arg(1)), "", true);
+    } else if (args.size() == 3 && args[0] == "inner") {
+        const size_t num_inner = arg(2);
+        int32_t side = 1;
+        while (static_cast<size_t>(side) * side < num_inner) {
+            ++side;
+        }
+        const int32_t size = 1000000000 / 2;
+        data.add_way(ring(0, 0, size, arg(1)), "outer");
+        const int32_t step = size / side;
+        for (size_t i = 0; i < num_inner; ++i) {
+            const int32_t x = static_cast<int32_t>(i) % side * step - size / 2;
+            const int32_t y = static_cast<int32_t>(i) / side * step - size / 2;
+            data.add_way(square(x, y, step / 2), "inner");
+        }
+        data.add_relation();
+    } else if (args.size() == 2 && args[0] == "touching") {
+        for (size_t i = 0; i < arg(1); ++i) {
+            data.add_way(square(static_cast<int32_t>(i) * 100, static_cast<int32_t>(i) * 100, 100), "outer");
+        }
+        data.add_relation();
+    } else if (args.size() == 2 && args[0] == "coastline") {
+        std::vector<osmium::Location> locations;
+        const int32_t n = static_cast<int32_t>(std::max(arg(1), 4ul) - 2);
+        for (int32_t i = 0; i < n; ++i) {
+            locations.emplace_back(i % 2 * 100, i * 10);
+        }
+        locations.emplace_back(-100, (n - 1) * 10);
+        locations.emplace_back(-100, 0);
+        locations.push_back(locations.front());
+        data.add_connected_ways(locations, 100);
+        data.add_relation();
+    } else {
+        return false;
+    }
+
+    data.run(collector);
+    return true;
+}
+
+static void run_file(const std::string& input_filename, collector_type& collector) {
+    osmium::io::Reader reader1(input_filename, osmium::osm_entity_bits::relation);
+    collector.read_relations(reader1);
+    reader1.close();
+
+    index_type index;
+    location_handler_type location_handler(index);
+    location_handler.ignore_errors();
+
+    osmium::io::Reader reader2(input_filename);
+    osmium::apply(reader2, location_handler, collector.handler());
+    reader2.close();
+}
+
+static double to_ms(std::chrono::nanoseconds time) {
+    return static_cast<double>(time.count()) / 1000000.0;
+}
+
+static void print_report(std::chrono::nanoseconds total_time) {
+    std::sort(timings.begin(), timings.end(), [](const Timing& a, const Timing& b) {
+        return a.time < b.time;
+    });
+
+    std::chrono::nanoseconds assembly_time{0};
+    for (const auto& timing : timings) {
+        assembly_time += timing.time;
+    }
+
+    std::cout << "Objects assembled: " << timings.size() << "\n";
+    std::cout << "Areas produced: " << areas_produced << "\n";
+    std::cout << "Areas failed: " << areas_failed << "\n";
+    std::cout << "Total time (ms): " << to_ms(total_time) << "\n";
+    std::cout << "Time in assembler (ms): " << to_ms(assembly_time) << "\n";
+
+    if (!timings.empty()) {
+        std::cout << "Time per object (ms):\n";
+        for (const double p : {50.0, 90.0, 99.0, 99.9, 100.0}) {
+            const size_t n = std::min(static_cast<size_t>(p / 100.0 * static_cast<double>(timings.size())), timings.size() - 1);
+            std::cout << "  p" << p << ": " << to_ms(timings[n].time) << "\n";
+        }
+
+        std::cout << "Slowest objects:\n";
+        const size_t num_slowest = std::min(timings.size(), size_t(10));
+        for (auto it = timings.rbegin(); it != timings.rbegin() + static_cast<std::ptrdiff_t>(num_slowest); ++it) {
+            std::cout << "  " << it->type << it->id << ": " << to_ms(it->time) << " ms\n";
+        }
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        // ru_maxrss is in kilobytes on Linux
+        std::cout << "Memory high-water mark (MB): " << usage.ru_maxrss / 1024 << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    collector_type collector{osmium::area::AssemblerConfig{}};
+    const auto start = std::chrono::steady_clock::now();
+
+    if (args.size() >= 2 && args[0] == "--synthetic") {
+        if (!run_synthetic(std::vector<std::string>(args.begin() + 1, args.end()), collector)) {
+            std::cerr << "Unknown synthetic data set\n";
+            exit(1);
+        }
+    } else if (args.size() == 1) {
+        run_file(args[0], collector);
+    } else {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE\n"
+                  << "       " << argv[0] << " --synthetic ring NUM_SEGMENTS\n"
+                  << "       " << argv[0] << " --synthetic inner NUM_SEGMENTS NUM_INNER_RINGS\n"
+                  << "       " << argv[0] << " --synthetic touching NUM_RINGS\n"
+                  << "       " << argv[0] << " --synthetic coastline NUM_SEGMENTS\n";
+        exit(1);
+    }
+
+    print_report(std::chrono::steady_clock::now() - start);
+}
+
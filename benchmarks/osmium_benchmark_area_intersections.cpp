@@ -0,0 +1,153 @@
+/*
+
+  Benchmark for the segment intersection check done by the area assembler.
+
+  Reads multipolygon relations and closed ways from an OSM file (such as
+  the multipolygon test cases from the osm-testdata repository) or
+  generates a synthetic ring with the given number of segments, and runs
+  the intersection check on them.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/multipolygon_collector.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/visitor.hpp>
+
+typedef osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
+typedef osmium::handler::NodeLocationsForWays<index_type> location_handler_type;
+
+struct Stats {
+    uint64_t objects = 0;
+    uint64_t segments = 0;
+    uint64_t with_intersections = 0;
+    std::chrono::nanoseconds time{0};
+    std::chrono::nanoseconds max_time{0};
+    osmium::object_id_type max_time_id = 0;
+};
+
+static Stats stats;
+
+/**
+ * Stands in for the Assembler in the MultipolygonCollector, but only does
+ * the segment intersection check.
+ */
+class IntersectionChecker {
+
+    osmium::area::detail::SegmentList m_segment_list;
+
+    void check(osmium::object_id_type id) {
+        const auto start = std::chrono::steady_clock::now();
+        m_segment_list.sort();
+        m_segment_list.erase_duplicate_segments();
+        const bool found = m_segment_list.find_intersections(nullptr);
+        const auto time = std::chrono::steady_clock::now() - start;
+
+        ++stats.objects;
+        stats.segments += m_segment_list.size();
+        if (found) {
+            ++stats.with_intersections;
+        }
+        stats.time += time;
+        if (time > stats.max_time) {
+            stats.max_time = time;
+            stats.max_time_id = id;
+        }
+    }
+
+public:
+
+    typedef osmium::area::AssemblerConfig config_type;
+
+    explicit IntersectionChecker(const config_type&) :
+        m_segment_list(false) {
+    }
+
+    void operator()(const osmium::Way& way, osmium::memory::Buffer&) {
+        m_segment_list.extract_segments_from_way(way, "outer");
+        check(way.id());
+    }
+
+    void operator()(const osmium::Relation& relation, const std::vector<size_t>& members, const osmium::memory::Buffer& in_buffer, osmium::memory::Buffer&) {
+        m_segment_list.extract_segments_from_ways(relation, members, in_buffer);
+        check(relation.id());
+    }
+
+}; // class IntersectionChecker
+
+// A long coastline-like ring going north in a narrow zigzag, so that most
+// of its segments overlap in x.
+static void check_synthetic_ring(size_t num_segments) {
+    osmium::memory::Buffer buffer(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int32_t> noise(0, 20);
+
+    {
+        osmium::builder::WayBuilder builder(buffer);
+        builder.object().set_id(1);
+        builder.add_user("");
+        osmium::builder::WayNodeListBuilder wnl_builder(buffer, &builder);
+        const int32_t n = static_cast<int32_t>(std::max(num_segments, size_t(4)) - 2);
+        for (int32_t i = 0; i < n; ++i) {
+            wnl_builder.add_node_ref(i + 1, osmium::Location(i % 2 * 100 + noise(gen), i * 10));
+        }
+        wnl_builder.add_node_ref(n + 1, osmium::Location(-100, (n - 1) * 10));
+        wnl_builder.add_node_ref(n + 2, osmium::Location(-100, 0));
+        wnl_builder.add_node_ref(1, osmium::Location(noise(gen) - 100, 0));
+    }
+    buffer.commit();
+
+    IntersectionChecker checker{osmium::area::AssemblerConfig{}};
+    checker(buffer.get<const osmium::Way>(0), buffer);
+}
+
+static void check_file(const std::string& input_filename) {
+    osmium::area::MultipolygonCollector<IntersectionChecker> collector{osmium::area::AssemblerConfig{}};
+
+    osmium::io::Reader reader1(input_filename, osmium::osm_entity_bits::relation);
+    collector.read_relations(reader1);
+    reader1.close();
+
+    index_type index;
+    location_handler_type location_handler(index);
+    location_handler.ignore_errors();
+
+    osmium::io::Reader reader2(input_filename);
+    osmium::apply(reader2, location_handler, collector.handler());
+    reader2.close();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string{argv[1]} == "--synthetic") {
+        check_synthetic_ring(std::strtoul(argv[2], nullptr, 10));
+    } else if (argc == 2) {
+        check_file(argv[1]);
+    } else {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE\n"
+                  << "       " << argv[0] << " --synthetic NUM_SEGMENTS\n";
+        exit(1);
+    }
+
+    std::cout << "Objects: " << stats.objects << "\n";
+    std::cout << "Segments: " << stats.segments << "\n";
+    std::cout << "Objects with intersections: " << stats.with_intersections << "\n";
+    std::cout << "Time (ms): " << std::chrono::duration_cast<std::chrono::milliseconds>(stats.time).count() << "\n";
+    std::cout << "Slowest object: " << stats.max_time_id << " ("
+              << std::chrono::duration_cast<std::chrono::microseconds>(stats.max_time).count() << " us)\n";
+}
+
@@ -0,0 +1,122 @@
+/*
+
+  Benchmark for the second pass of the relations collector.
+
+  Reads relations and their member ways from an OSM file or generates a
+  synthetic data set with the given number of relations, each with ten
+  way members, and measures how fast the member ways are added to the
+  relations in the second pass. In the synthetic data only every tenth
+  way is a member of a relation.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <iostream>
+#include <string>
+
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/relations/collector.hpp>
+#include <osmium/visitor.hpp>
+
+class CountingCollector : public osmium::relations::Collector<CountingCollector, false, true, false> {
+
+public:
+
+    uint64_t complete = 0;
+
+    void complete_relation(osmium::relations::RelationMeta&) {
+        ++complete;
+    }
+
+}; // class CountingCollector
+
+static const int members_per_relation = 10;
+static const int ways_per_member = 10;
+
+static void add_relation(osmium::memory::Buffer& buffer, osmium::object_id_type id) {
+    {
+        osmium::builder::RelationBuilder builder(buffer);
+        builder.object().set_id(id);
+        builder.add_user("");
+        osmium::builder::RelationMemberListBuilder rml_builder(buffer, &builder);
+        for (int i = 0; i < members_per_relation; ++i) {
+            rml_builder.add_member(osmium::item_type::way, ((id - 1) * members_per_relation + i + 1) * ways_per_member, "");
+        }
+    }
+    buffer.commit();
+}
+
+static void add_way(osmium::memory::Buffer& buffer, osmium::object_id_type id) {
+    {
+        osmium::builder::WayBuilder builder(buffer);
+        builder.object().set_id(id);
+        builder.add_user("");
+        osmium::builder::WayNodeListBuilder wnl_builder(buffer, &builder);
+        wnl_builder.add_node_ref(id);
+        wnl_builder.add_node_ref(id + 1);
+    }
+    buffer.commit();
+}
+
+int main(int argc, char* argv[]) {
+    CountingCollector collector;
+    uint64_t objects = 0;
+    std::chrono::steady_clock::duration time{0};
+
+    if (argc == 3 && std::string{argv[1]} == "--synthetic") {
+        const osmium::object_id_type num_relations = std::strtoll(argv[2], nullptr, 10);
+
+        osmium::memory::Buffer relations(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+        for (osmium::object_id_type id = 1; id <= num_relations; ++id) {
+            add_relation(relations, id);
+        }
+        collector.read_relations(relations.begin(), relations.end());
+
+        // Ways are handed to the collector in buffers of 10000 like they
+        // would be when reading a file.
+        const osmium::object_id_type num_ways = num_relations * members_per_relation * ways_per_member;
+        osmium::memory::Buffer ways(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+        for (osmium::object_id_type id = 1; id <= num_ways; id += 10000) {
+            ways.clear();
+            for (osmium::object_id_type n = id; n < id + 10000 && n <= num_ways; ++n) {
+                add_way(ways, n);
+            }
+            const auto start = std::chrono::steady_clock::now();
+            osmium::apply(ways, collector.handler());
+            time += std::chrono::steady_clock::now() - start;
+        }
+        objects = static_cast<uint64_t>(num_ways);
+    } else if (argc == 2) {
+        osmium::io::Reader reader1(argv[1], osmium::osm_entity_bits::relation);
+        collector.read_relations(reader1);
+        reader1.close();
+
+        osmium::io::Reader reader2(argv[1], osmium::osm_entity_bits::way);
+        while (osmium::memory::Buffer buffer = reader2.read()) {
+            objects += static_cast<uint64_t>(std::distance(buffer.begin(), buffer.end()));
+            const auto start = std::chrono::steady_clock::now();
+            osmium::apply(buffer, collector.handler());
+            time += std::chrono::steady_clock::now() - start;
+        }
+        reader2.close();
+    } else {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE\n"
+                  << "       " << argv[0] << " --synthetic NUM_RELATIONS\n";
+        exit(1);
+    }
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time).count();
+    std::cout << "Ways: " << objects << "\n";
+    std::cout << "Complete relations: " << collector.complete << "\n";
+    std::cout << "Time in second pass (ms): " << ms << "\n";
+    if (ms > 0) {
+        std::cout << "Ways per second: " << objects * 1000 / static_cast<uint64_t>(ms) << "\n";
+    }
+}
+
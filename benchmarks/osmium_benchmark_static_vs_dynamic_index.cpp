@@ -9,6 +9,11 @@
   number of runs depends on the size of the input, but is never smaller
   than 10.
 
+  The dynamically configured index is run twice: Once through
+  osmium::apply() with one virtual call per node, and once through
+  NodeLocationsForWays::process_buffer(), which finds out the concrete
+  index type once for the buffer and looks up locations in batches.
+
   Do not run this with very large input files! It will need about 10 times
   as much RAM as the file size of the input file.
 
@@ -63,6 +68,10 @@ int main(int argc, char* argv[]) {
     double dynamic_sum = 0;
     double dynamic_max = 0;
 
+    double batched_min = std::numeric_limits<double>::max();
+    double batched_sum = 0;
+    double batched_max = 0;
+
     for (int i = 0; i < runs; ++i) {
 
         {
@@ -109,13 +118,38 @@ int main(int argc, char* argv[]) {
             if (duration > dynamic_max) dynamic_max = duration;
             dynamic_sum += duration;
         }
+
+        {
+            // dynamic index with batched lookups and dispatch to concrete type
+            osmium::memory::Buffer tmp_buffer(buffer.committed());
+            for (const auto& item : buffer) {
+                tmp_buffer.add_item(item);
+                tmp_buffer.commit();
+            }
+
+            std::unique_ptr<dynamic_index_type> index = map_factory.create_map(location_store);
+            dynamic_location_handler_type dynamic_location_handler(*index);
+            dynamic_location_handler.ignore_errors();
+
+            auto start = std::chrono::steady_clock::now();
+            dynamic_location_handler.process_buffer(tmp_buffer);
+            auto end = std::chrono::steady_clock::now();
+
+            double duration = std::chrono::duration<double, std::milli>(end-start).count();
+
+            if (duration < batched_min) batched_min = duration;
+            if (duration > batched_max) batched_max = duration;
+            batched_sum += duration;
+        }
     }
 
     double static_avg = static_sum/runs;
     double dynamic_avg = dynamic_sum/runs;
+    double batched_avg = batched_sum/runs;
 
     std::cout << "static  min=" << static_min << "ms avg=" << static_avg << "ms max=" << static_max << "ms\n";
     std::cout << "dynamic min=" << dynamic_min << "ms avg=" << dynamic_avg << "ms max=" << dynamic_max << "ms\n";
+    std::cout << "batched min=" << batched_min << "ms avg=" << batched_avg << "ms max=" << batched_max << "ms\n";
 
     double rfactor = 100.0;
     double diff_min = std::round((dynamic_min - static_min) * rfactor) / rfactor;
@@ -131,5 +165,18 @@ int main(int argc, char* argv[]) {
     std::cout << " min=" << diff_min << "ms (" << percent_min << "%)";
     std::cout << " avg=" << diff_avg << "ms (" << percent_avg << "%)";
     std::cout << " max=" << diff_max << "ms (" << percent_max << "%)\n";
+
+    double bdiff_min = std::round((batched_min - static_min) * rfactor) / rfactor;
+    double bdiff_avg = std::round((batched_avg - static_avg) * rfactor) / rfactor;
+    double bdiff_max = std::round((batched_max - static_max) * rfactor) / rfactor;
+
+    double bpercent_min = std::round((100.0 * bdiff_min / static_min) * prfactor) / prfactor;
+    double bpercent_avg = std::round((100.0 * bdiff_avg / static_avg) * prfactor) / prfactor;
+    double bpercent_max = std::round((100.0 * bdiff_max / static_max) * prfactor) / prfactor;
+
+    std::cout << "batched difference:";
+    std::cout << " min=" << bdiff_min << "ms (" << bpercent_min << "%)";
+    std::cout << " avg=" << bdiff_avg << "ms (" << bpercent_avg << "%)";
+    std::cout << " max=" << bdiff_max << "ms (" << bpercent_max << "%)\n";
 }
 
@@ -0,0 +1,100 @@
+/*
+
+  Benchmark for the text output formats.
+
+  Reads an OSM file completely into memory. Then measures how fast all tag
+  keys and values, user names, and roles are escaped for the XML and OPL
+  formats and how long it takes to write the whole data as XML and as
+  OPL to /dev/null.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <osmium/io/any_input.hpp>
+#include <osmium/io/detail/string_util.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/osm.hpp>
+
+using duration = std::chrono::steady_clock::duration;
+
+static long to_ms(duration time) {
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(time).count());
+}
+
+template <typename TFunc>
+static duration encode_all(const std::vector<const char*>& strings, std::string& out, TFunc&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    for (const char* str : strings) {
+        out.clear();
+        func(out, str);
+    }
+    return std::chrono::steady_clock::now() - start;
+}
+
+static duration write_all(const std::vector<osmium::memory::Buffer>& buffers, const char* format) {
+    const auto start = std::chrono::steady_clock::now();
+    osmium::io::Writer writer(osmium::io::File("/dev/null", format), osmium::io::Header(), osmium::io::overwrite::allow);
+    for (const auto& buffer : buffers) {
+        osmium::memory::Buffer copy(buffer.committed());
+        copy.add_buffer(buffer);
+        copy.commit();
+        writer(std::move(copy));
+    }
+    writer.close();
+    return std::chrono::steady_clock::now() - start;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " OSMFILE\n";
+        exit(1);
+    }
+
+    std::vector<osmium::memory::Buffer> buffers;
+    osmium::io::Reader reader(argv[1]);
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        buffers.push_back(std::move(buffer));
+    }
+    reader.close();
+
+    std::vector<const char*> strings;
+    uint64_t bytes = 0;
+    for (const auto& buffer : buffers) {
+        for (auto it = buffer.cbegin<osmium::OSMObject>(); it != buffer.cend<osmium::OSMObject>(); ++it) {
+            const osmium::OSMObject& object = *it;
+            strings.push_back(object.user());
+            for (const auto& tag : object.tags()) {
+                strings.push_back(tag.key());
+                strings.push_back(tag.value());
+            }
+            if (object.type() == osmium::item_type::relation) {
+                for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                    strings.push_back(member.role());
+                }
+            }
+        }
+    }
+    for (const char* str : strings) {
+        bytes += std::strlen(str);
+    }
+
+    std::string out;
+    const auto xml_encode_time = encode_all(strings, out, osmium::io::detail::append_xml_encoded_string);
+    const auto opl_encode_time = encode_all(strings, out, osmium::io::detail::append_utf8_encoded_string);
+
+    std::cout << "Strings: " << strings.size() << " (" << bytes << " bytes)\n";
+    std::cout << "XML escaping (ms): " << to_ms(xml_encode_time) << "\n";
+    std::cout << "OPL escaping (ms): " << to_ms(opl_encode_time) << "\n";
+    std::cout << "Writing XML (ms): " << to_ms(write_all(buffers, "xml")) << "\n";
+    std::cout << "Writing OPL (ms): " << to_ms(write_all(buffers, "opl")) << "\n";
+}
@@ -0,0 +1,35 @@
+#!/bin/sh
+#
+#  run_benchmark_area.sh
+#
+
+set -e
+
+BENCHMARK_NAME=area
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+# The report of each run (areas produced and failed, timing percentiles,
+# slowest objects, memory high-water mark) goes into its own file.
+REPORT_DIR=$OB_DIR/reports_$BENCHMARK_NAME
+mkdir -p $REPORT_DIR
+echo "# reports in $REPORT_DIR"
+
+echo "# file size num mem time cpu_kernel cpu_user cpu_percent cmd options"
+for data in $OB_DATA_FILES; do
+    filename=`basename $data`
+    filesize=`stat --format="%s" --dereference $data`
+    for n in $OB_SEQ; do
+        $OB_TIME_CMD -f "$filename $filesize $n $OB_TIME_FORMAT" $CMD $data 2>&1 >$REPORT_DIR/$filename-$n.txt | sed -e "s%$DATA_DIR/%%" | sed -e "s%$OB_DIR/%%"
+    done
+done
+
+for synthetic in "ring 1000000" "inner 10000 10000" "touching 10000" "coastline 1000000"; do
+    name=synthetic-`echo $synthetic | tr ' ' '-'`
+    for n in $OB_SEQ; do
+        $OB_TIME_CMD -f "$name 0 $n $OB_TIME_FORMAT" $CMD --synthetic $synthetic 2>&1 >$REPORT_DIR/$name-$n.txt | sed -e "s%$OB_DIR/%%"
+    done
+done
+
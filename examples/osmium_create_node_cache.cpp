@@ -1,7 +1,12 @@
 /*
 
   This reads an OSM file and writes out the node locations to a cache
-  file.
+  file. The cache file has a header describing its contents, it can be
+  used with osmium::index::map::IndexFileMap.
+
+  The locations are collected in a file-backed index first, so that the
+  index doesn't have to fit into memory. This scratch file is created
+  next to the cache file and removed at the end.
 
   The code in this example file is released into the Public Domain.
 
@@ -10,19 +15,20 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <iostream>
+#include <string>
 
 #include <osmium/io/any_input.hpp>
 
+#include <osmium/index/index_file.hpp>
 #include <osmium/index/map/dummy.hpp>
-#include <osmium/index/map/dense_mmap_array.hpp>
 #include <osmium/index/map/dense_file_array.hpp>
 
 #include <osmium/handler/node_locations_for_ways.hpp>
 #include <osmium/visitor.hpp>
 
 typedef osmium::index::map::Dummy<osmium::unsigned_object_id_type, osmium::Location> index_neg_type;
-//typedef osmium::index::map::DenseMmapArray<osmium::unsigned_object_id_type, osmium::Location> index_pos_type;
 typedef osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location> index_pos_type;
 
 typedef osmium::handler::NodeLocationsForWays<index_pos_type, index_neg_type> location_handler_type;
@@ -35,14 +41,25 @@ int main(int argc, char* argv[]) {
 
     std::string input_filename(argv[1]);
     osmium::io::Reader reader(input_filename, osmium::osm_entity_bits::node);
+    const auto source = osmium::index::index_file_source_from_header(reader.header());
 
-    int fd = open(argv[2], O_RDWR | O_CREAT, 0666);
+    int fd = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, 0666);
     if (fd == -1) {
         std::cerr << "Can not open node cache file '" << argv[2] << "': " << strerror(errno) << "\n";
         return 1;
     }
 
-    index_pos_type index_pos {fd};
+    // The scratch file is unlinked right away, the data stays on disk
+    // until the file descriptor is closed.
+    const std::string scratch_filename = std::string(argv[2]) + ".tmp";
+    int scratch_fd = open(scratch_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (scratch_fd == -1) {
+        std::cerr << "Can not open scratch file '" << scratch_filename << "': " << strerror(errno) << "\n";
+        return 1;
+    }
+    unlink(scratch_filename.c_str());
+
+    index_pos_type index_pos{scratch_fd};
     index_neg_type index_neg;
     location_handler_type location_handler(index_pos, index_neg);
     location_handler.ignore_errors();
@@ -50,6 +67,10 @@ int main(int argc, char* argv[]) {
     osmium::apply(reader, location_handler);
     reader.close();
 
+    osmium::index::write_index_file(fd, index_pos, source);
+    close(fd);
+    close(scratch_fd);
+
     return 0;
 }
 
@@ -15,15 +15,13 @@
 #include <osmium/io/any_input.hpp>
 
 #include <osmium/index/map/dummy.hpp>
-#include <osmium/index/map/dense_file_array.hpp>
-#include <osmium/index/map/dense_mmap_array.hpp>
+#include <osmium/index/map/index_file_map.hpp>
 
 #include <osmium/handler/node_locations_for_ways.hpp>
 #include <osmium/visitor.hpp>
 
 typedef osmium::index::map::Dummy<osmium::unsigned_object_id_type, osmium::Location> index_neg_type;
-//typedef osmium::index::map::DenseMmapArray<osmium::unsigned_object_id_type, osmium::Location> index_pos_type;
-typedef osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location> index_pos_type;
+typedef osmium::index::map::IndexFileMap<osmium::unsigned_object_id_type, osmium::Location> index_pos_type;
 
 typedef osmium::handler::NodeLocationsForWays<index_pos_type, index_neg_type> location_handler_type;
 
@@ -48,13 +46,14 @@ int main(int argc, char* argv[]) {
     std::string input_filename(argv[1]);
     osmium::io::Reader reader(input_filename, osmium::osm_entity_bits::way);
 
-    int fd = open(argv[2], O_RDWR);
+    int fd = open(argv[2], O_RDONLY);
     if (fd == -1) {
         std::cerr << "Can not open node cache file '" << argv[2] << "': " << strerror(errno) << "\n";
         return 1;
     }
 
     index_pos_type index_pos {fd};
+    close(fd);
     index_neg_type index_neg;
     location_handler_type location_handler(index_pos, index_neg);
     location_handler.ignore_errors();
@@ -35,18 +35,23 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <deque>
 #include <iostream>
 #include <iterator>
-#include <list>
+#include <limits>
 #include <set>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/tags/filter.hpp>
@@ -93,21 +98,74 @@ namespace osmium {
 
             const AssemblerConfig m_config;
 
+            // All the following members only hold data while one area is
+            // assembled. They are cleared before each area, but keep their
+            // allocated memory, so that an Assembler object used for many
+            // areas doesn't have to allocate it again and again.
+
             // The way segments
             osmium::area::detail::SegmentList m_segment_list;
 
-            // The rings we are building from the way segments
-            std::list<ProtoRing> m_rings;
+            // The rings we are building from the way segments. Rings are
+            // referred to by their index in here, which is also the order
+            // in which they were created. Rings that are merged into other
+            // rings are left in place with their segments removed until
+            // all rings are built. (A deque doesn't invalidate references
+            // when rings are added.)
+            std::deque<ProtoRing> m_rings;
+
+            // Index of the rings by location of their first and last node.
+            // Only open rings are in here.
+            std::unordered_multimap<osmium::Location, size_t> m_ring_ends;
+
+            // Number of segments added to rings so far that start or end at
+            // each location.
+            std::unordered_map<osmium::Location, uint32_t> m_segments_at;
+
+            // Number of locations where at least three segments start or
+            // end. Rings can only touch themselves at those locations.
+            size_t m_num_junctions = 0;
 
             std::vector<ProtoRing*> m_outer_rings;
             std::vector<ProtoRing*> m_inner_rings;
 
             int m_inner_outer_mismatches { 0 };
 
+            // Locations of the nodes of a way, used for the simple ring check.
+            std::vector<osmium::Location> m_locations;
+
             bool debug() const {
                 return m_config.debug;
             }
 
+            /**
+             * Clear all data from the previous area.
+             */
+            void reset() {
+                m_segment_list.clear();
+                m_rings.clear();
+                m_ring_ends.clear();
+                m_segments_at.clear();
+                m_num_junctions = 0;
+                m_outer_rings.clear();
+                m_inner_rings.clear();
+                m_inner_outer_mismatches = 0;
+            }
+
+            /**
+             * Report a duplicate node to the problem reporter if the given
+             * NodeRefs, which must have the same location, have different
+             * ids.
+             */
+            void check_for_duplicate_node(const osmium::NodeRef& nr1, const osmium::NodeRef& nr2) {
+                assert(nr1.location() == nr2.location());
+                if (nr1.ref() != nr2.ref()) {
+                    if (m_config.problem_reporter) {
+                        m_config.problem_reporter->report_duplicate_node(nr1.ref(), nr2.ref(), nr1.location());
+                    }
+                }
+            }
+
             /**
              * Checks whether the given NodeRefs have the same location.
              * Uses the actual location for the test, not the id. If both
@@ -118,11 +176,7 @@ namespace osmium {
                 if (nr1.location() != nr2.location()) {
                     return false;
                 }
-                if (nr1.ref() != nr2.ref()) {
-                    if (m_config.problem_reporter) {
-                        m_config.problem_reporter->report_duplicate_node(nr1.ref(), nr2.ref(), nr1.location());
-                    }
-                }
+                check_for_duplicate_node(nr1, nr2);
                 return true;
             }
 
@@ -240,40 +294,91 @@ namespace osmium {
                 return open_rings;
             }
 
+            static constexpr size_t no_ring = std::numeric_limits<size_t>::max();
+
+            void add_ring_end(const osmium::Location& location, size_t n) {
+                m_ring_ends.emplace(location, n);
+            }
+
+            void remove_ring_end(const osmium::Location& location, size_t n) {
+                const auto range = m_ring_ends.equal_range(location);
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (it->second == n) {
+                        m_ring_ends.erase(it);
+                        return;
+                    }
+                }
+            }
+
+            /// Add the ends of ring n to the index if it is open.
+            void index_ring(size_t n) {
+                const ProtoRing& ring = m_rings[n];
+                if (!ring.segments().empty() && !ring.closed()) {
+                    add_ring_end(ring.get_segment_front().first().location(), n);
+                    add_ring_end(ring.get_segment_back().second().location(), n);
+                }
+            }
+
+            /// Remove the ends of ring n from the index. Call before changing the ring.
+            void unindex_ring(size_t n) {
+                const ProtoRing& ring = m_rings[n];
+                if (!ring.segments().empty() && !ring.closed()) {
+                    remove_ring_end(ring.get_segment_front().first().location(), n);
+                    remove_ring_end(ring.get_segment_back().second().location(), n);
+                }
+            }
+
+            /**
+             * Find the first (oldest) open ring starting or ending at the
+             * given location.
+             *
+             * @returns Index of the ring or no_ring if there is none.
+             */
+            size_t find_ring_end(const osmium::Location& location) const {
+                size_t n = no_ring;
+                const auto range = m_ring_ends.equal_range(location);
+                for (auto it = range.first; it != range.second; ++it) {
+                    n = std::min(n, it->second);
+                }
+                return n;
+            }
+
             /**
              * Check whether there are any rings that can be combined with the
              * given ring to one larger ring by appending the other ring to
              * the end of this ring.
              * If the rings can be combined they are and the function returns
              * true.
+             *
+             * Ring n must not be in the ring end index.
              */
-            bool possibly_combine_rings_back(ProtoRing& ring) {
+            bool possibly_combine_rings_back(size_t n) {
+                ProtoRing& ring = m_rings[n];
                 const osmium::NodeRef& nr = ring.get_segment_back().second();
 
                 if (debug()) {
                     std::cerr << "      possibly_combine_rings_back()\n";
                 }
-                for (auto it = m_rings.begin(); it != m_rings.end(); ++it) {
-                    if (&*it != &ring && !it->closed()) {
-                        if (has_same_location(nr, it->get_segment_front().first())) {
-                            if (debug()) {
-                                std::cerr << "      ring.last=it->first\n";
-                            }
-                            ring.merge_ring(*it, debug());
-                            m_rings.erase(it);
-                            return true;
-                        }
-                        if (has_same_location(nr, it->get_segment_back().second())) {
-                            if (debug()) {
-                                std::cerr << "      ring.last=it->last\n";
-                            }
-                            ring.merge_ring_reverse(*it, debug());
-                            m_rings.erase(it);
-                            return true;
-                        }
+                const size_t other = find_ring_end(nr.location());
+                if (other == no_ring) {
+                    return false;
+                }
+                ProtoRing& other_ring = m_rings[other];
+                unindex_ring(other);
+                if (has_same_location(nr, other_ring.get_segment_front().first())) {
+                    if (debug()) {
+                        std::cerr << "      ring.last=it->first\n";
                     }
+                    ring.merge_ring(other_ring, debug());
+                } else {
+                    check_for_duplicate_node(nr, other_ring.get_segment_back().second());
+                    if (debug()) {
+                        std::cerr << "      ring.last=it->last\n";
+                    }
+                    ring.merge_ring_reverse(other_ring, debug());
                 }
-                return false;
+                other_ring.segments().clear();
+                return true;
             }
 
             /**
@@ -282,36 +387,38 @@ namespace osmium {
              * the start of this ring.
              * If the rings can be combined they are and the function returns
              * true.
+             *
+             * Ring n must not be in the ring end index.
              */
-            bool possibly_combine_rings_front(ProtoRing& ring) {
+            bool possibly_combine_rings_front(size_t n) {
+                ProtoRing& ring = m_rings[n];
                 const osmium::NodeRef& nr = ring.get_segment_front().first();
 
                 if (debug()) {
                     std::cerr << "      possibly_combine_rings_front()\n";
                 }
-                for (auto it = m_rings.begin(); it != m_rings.end(); ++it) {
-                    if (&*it != &ring && !it->closed()) {
-                        if (has_same_location(nr, it->get_segment_back().second())) {
-                            if (debug()) {
-                                std::cerr << "      ring.first=it->last\n";
-                            }
-                            ring.swap_segments(*it);
-                            ring.merge_ring(*it, debug());
-                            m_rings.erase(it);
-                            return true;
-                        }
-                        if (has_same_location(nr, it->get_segment_front().first())) {
-                            if (debug()) {
-                                std::cerr << "      ring.first=it->first\n";
-                            }
-                            ring.reverse();
-                            ring.merge_ring(*it, debug());
-                            m_rings.erase(it);
-                            return true;
-                        }
+                const size_t other = find_ring_end(nr.location());
+                if (other == no_ring) {
+                    return false;
+                }
+                ProtoRing& other_ring = m_rings[other];
+                unindex_ring(other);
+                if (has_same_location(nr, other_ring.get_segment_back().second())) {
+                    if (debug()) {
+                        std::cerr << "      ring.first=it->last\n";
                     }
+                    ring.swap_segments(other_ring);
+                    ring.merge_ring(other_ring, debug());
+                } else {
+                    check_for_duplicate_node(nr, other_ring.get_segment_front().first());
+                    if (debug()) {
+                        std::cerr << "      ring.first=it->first\n";
+                    }
+                    ring.reverse();
+                    ring.merge_ring(other_ring, debug());
                 }
-                return false;
+                other_ring.segments().clear();
+                return true;
             }
 
             void split_off_subring(osmium::area::detail::ProtoRing& ring, osmium::area::detail::ProtoRing::segments_type::iterator it, osmium::area::detail::ProtoRing::segments_type::iterator it_begin, osmium::area::detail::ProtoRing::segments_type::iterator it_end) {
@@ -328,8 +435,21 @@ namespace osmium {
                 m_rings.push_back(std::move(new_ring));
             }
 
+            void count_segment_end(const osmium::Location& location) {
+                if (++m_segments_at[location] == 3) {
+                    ++m_num_junctions;
+                }
+            }
+
+            uint32_t segments_at(const osmium::Location& location) const {
+                const auto it = m_segments_at.find(location);
+                return it == m_segments_at.end() ? 0 : it->second;
+            }
+
+            // A ring can only have a closed subring ending at nr if there is
+            // at least one other segment at that location.
             bool has_closed_subring_back(ProtoRing& ring, const NodeRef& nr) {
-                if (ring.segments().size() < 3) {
+                if (ring.segments().size() < 3 || segments_at(nr.location()) < 2) {
                     return false;
                 }
                 if (debug()) {
@@ -346,7 +466,7 @@ namespace osmium {
             }
 
             bool has_closed_subring_front(ProtoRing& ring, const NodeRef& nr) {
-                if (ring.segments().size() < 3) {
+                if (ring.segments().size() < 3 || segments_at(nr.location()) < 2) {
                     return false;
                 }
                 if (debug()) {
@@ -367,6 +487,12 @@ namespace osmium {
                     std::cerr << "      check_for_closed_subring()\n";
                 }
 
+                // A ring visiting a location twice has at least three
+                // segments there.
+                if (m_num_junctions == 0) {
+                    return false;
+                }
+
                 osmium::area::detail::ProtoRing::segments_type segments(ring.segments().size());
                 std::copy(ring.segments().begin(), ring.segments().end(), segments.begin());
                 std::sort(segments.begin(), segments.end());
@@ -400,26 +526,44 @@ namespace osmium {
                 return true;
             }
 
-            void combine_rings_front(const osmium::area::detail::NodeRefSegment& segment, ProtoRing& ring) {
+            // Add rings split off from other rings to the ring end index.
+            // These are usually closed, so this doesn't do anything.
+            void index_new_rings(size_t first) {
+                for (; first < m_rings.size(); ++first) {
+                    index_ring(first);
+                }
+            }
+
+            void combine_rings_front(const osmium::area::detail::NodeRefSegment& segment, size_t n) {
                 if (debug()) {
                     std::cerr << " => match at front of ring\n";
                 }
+                const size_t num_rings = m_rings.size();
+                unindex_ring(n);
+                ProtoRing& ring = m_rings[n];
                 ring.add_segment_front(segment);
                 has_closed_subring_front(ring, segment.first());
-                if (possibly_combine_rings_front(ring)) {
+                if (possibly_combine_rings_front(n)) {
                     check_for_closed_subring(ring);
                 }
+                index_ring(n);
+                index_new_rings(num_rings);
             }
 
-            void combine_rings_back(const osmium::area::detail::NodeRefSegment& segment, ProtoRing& ring) {
+            void combine_rings_back(const osmium::area::detail::NodeRefSegment& segment, size_t n) {
                 if (debug()) {
                     std::cerr << " => match at back of ring\n";
                 }
+                const size_t num_rings = m_rings.size();
+                unindex_ring(n);
+                ProtoRing& ring = m_rings[n];
                 ring.add_segment_back(segment);
                 has_closed_subring_back(ring, segment.second());
-                if (possibly_combine_rings_back(ring)) {
+                if (possibly_combine_rings_back(n)) {
                     check_for_closed_subring(ring);
                 }
+                index_ring(n);
+                index_new_rings(num_rings);
             }
 
             /**
@@ -448,43 +592,40 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Add segment to the first (oldest) open ring that starts or
+             * ends at one of its nodes.
+             *
+             * @returns false if there is no such ring.
+             */
             bool add_to_existing_ring(osmium::area::detail::NodeRefSegment segment) {
-                int n = 0;
-                for (auto& ring : m_rings) {
-                    if (debug()) {
-                        std::cerr << "    check against ring " << n << " " << ring;
-                    }
-                    if (ring.closed()) {
-                        if (debug()) {
-                            std::cerr << " => ring CLOSED\n";
-                        }
-                    } else {
-                        if (has_same_location(ring.get_segment_back().second(), segment.first())) {
-                            combine_rings_back(segment, ring);
-                            return true;
-                        }
-                        if (has_same_location(ring.get_segment_back().second(), segment.second())) {
-                            segment.swap_locations();
-                            combine_rings_back(segment, ring);
-                            return true;
-                        }
-                        if (has_same_location(ring.get_segment_front().first(), segment.first())) {
-                            segment.swap_locations();
-                            combine_rings_front(segment, ring);
-                            return true;
-                        }
-                        if (has_same_location(ring.get_segment_front().first(), segment.second())) {
-                            combine_rings_front(segment, ring);
-                            return true;
-                        }
-                        if (debug()) {
-                            std::cerr << " => no match\n";
-                        }
-                    }
+                const size_t n = std::min(find_ring_end(segment.first().location()),
+                                          find_ring_end(segment.second().location()));
+                if (n == no_ring) {
+                    return false;
+                }
 
-                    ++n;
+                const ProtoRing& ring = m_rings[n];
+                if (debug()) {
+                    std::cerr << "    check against ring " << n << " " << ring;
                 }
-                return false;
+                if (has_same_location(ring.get_segment_back().second(), segment.first())) {
+                    combine_rings_back(segment, n);
+                    return true;
+                }
+                if (has_same_location(ring.get_segment_back().second(), segment.second())) {
+                    segment.swap_locations();
+                    combine_rings_back(segment, n);
+                    return true;
+                }
+                if (has_same_location(ring.get_segment_front().first(), segment.first())) {
+                    segment.swap_locations();
+                    combine_rings_front(segment, n);
+                    return true;
+                }
+                check_for_duplicate_node(ring.get_segment_front().first(), segment.second());
+                combine_rings_front(segment, n);
+                return true;
             }
 
             void check_inner_outer(ProtoRing& ring) {
@@ -496,12 +637,14 @@ namespace osmium {
                 int count = 0;
                 int above = 0;
 
-                for (auto it = m_segment_list.begin(); it != m_segment_list.end() && it->first().location().x() <= min_node.location().x(); ++it) {
-                    if (!ring.contains(*it)) {
+                // Only segments whose y range contains the location of the
+                // min_node can be counted, the y index finds them quickly.
+                m_segment_list.for_each_segment_left_of(min_node.location(), [&](const osmium::area::detail::NodeRefSegment& segment) {
+                    if (!ring.contains(segment)) {
                         if (debug()) {
-                            std::cerr << "      segments for count: " << *it;
+                            std::cerr << "      segments for count: " << segment;
                         }
-                        if (it->to_left_of(min_node.location())) {
+                        if (segment.to_left_of(min_node.location())) {
                             ++count;
                             if (debug()) {
                                 std::cerr << " counted\n";
@@ -511,18 +654,18 @@ namespace osmium {
                                 std::cerr << " not counted\n";
                             }
                         }
-                        if (it->first().location() == min_node.location()) {
-                            if (it->second().location().y() > min_node.location().y()) {
+                        if (segment.first().location() == min_node.location()) {
+                            if (segment.second().location().y() > min_node.location().y()) {
                                 ++above;
                             }
                         }
-                        if (it->second().location() == min_node.location()) {
-                            if (it->first().location().y() > min_node.location().y()) {
+                        if (segment.second().location() == min_node.location()) {
+                            if (segment.first().location().y() > min_node.location().y()) {
                                 ++above;
                             }
                         }
                     }
-                }
+                });
 
                 if (debug()) {
                     std::cerr << "      count=" << count << " above=" << above << "\n";
@@ -568,6 +711,58 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Check whether the way is a simple closed ring, ie. it is
+             * closed by the same node, all node locations are valid and no
+             * location is used twice (except for the first and last node).
+             * Anything else might need problems to be reported and is left
+             * to the general ring building code.
+             */
+            bool is_simple_closed_way(const osmium::Way& way) {
+                // At least three different nodes plus the closing one
+                if (way.nodes().size() < 4 || !way.ends_have_same_id() || !way.ends_have_same_location()) {
+                    return false;
+                }
+
+                m_locations.clear();
+                for (const osmium::NodeRef& nr : way.nodes()) {
+                    if (!nr.location()) {
+                        return false;
+                    }
+                    m_locations.push_back(nr.location());
+                }
+                m_locations.pop_back();
+
+                std::sort(m_locations.begin(), m_locations.end());
+                return std::adjacent_find(m_locations.begin(), m_locations.end()) == m_locations.end();
+            }
+
+            /**
+             * Create the ring for a simple closed way (see
+             * is_simple_closed_way()) directly from its nodes. Only the
+             * intersection check is needed, the rings don't have to be
+             * assembled from the segments.
+             */
+            bool create_ring_from_simple_way(const osmium::Way& way, osmium::builder::AreaBuilder& builder) {
+                if (debug()) {
+                    std::cerr << "  simple closed way\n";
+                }
+
+                m_segment_list.sort();
+                if (m_segment_list.find_intersections(m_config.problem_reporter)) {
+                    return false;
+                }
+
+                add_tags_to_area(builder, way);
+
+                osmium::builder::OuterRingBuilder ring_builder(builder.buffer(), &builder);
+                for (const osmium::NodeRef& nr : way.nodes()) {
+                    ring_builder.add_node_ref(nr);
+                }
+
+                return true;
+            }
+
             /**
              * Create rings from segments.
              */
@@ -590,14 +785,24 @@ namespace osmium {
                     if (debug()) {
                         std::cerr << "  checking segment " << segment << "\n";
                     }
+                    count_segment_end(segment.first().location());
+                    count_segment_end(segment.second().location());
                     if (!add_to_existing_ring(segment)) {
                         if (debug()) {
                             std::cerr << "    new ring for segment " << segment << "\n";
                         }
                         m_rings.emplace_back(segment);
+                        index_ring(m_rings.size() - 1);
                     }
                 }
 
+                // Remove rings that were merged into other rings.
+                m_rings.erase(std::remove_if(m_rings.begin(), m_rings.end(), [](const ProtoRing& ring) {
+                    return ring.segments().empty();
+                }), m_rings.end());
+                m_ring_ends.clear();
+                m_segments_at.clear();
+
                 if (debug()) {
                     std::cerr << "  Rings:\n";
                     for (const auto& ring : m_rings) {
@@ -623,6 +828,7 @@ namespace osmium {
                 if (m_rings.size() == 1) {
                     m_outer_rings.push_back(&m_rings.front());
                 } else {
+                    m_segment_list.build_y_index();
                     for (auto& ring : m_rings) {
                         check_inner_outer(ring);
                         if (ring.outer()) {
@@ -647,10 +853,19 @@ namespace osmium {
                         std::sort(m_outer_rings.begin(), m_outer_rings.end(), [](ProtoRing* a, ProtoRing* b) {
                             return a->area() < b->area();
                         });
+                        // An inner ring can only be in an outer ring if its
+                        // test point is in the bounding box of the outer ring,
+                        // so the expensive is_in() check is only needed then.
+                        std::vector<osmium::Box> outer_boxes;
+                        outer_boxes.reserve(m_outer_rings.size());
+                        for (const auto outer : m_outer_rings) {
+                            outer_boxes.push_back(outer->envelope());
+                        }
                         for (auto inner : m_inner_rings) {
-                            for (auto outer : m_outer_rings) {
-                                if (inner->is_in(outer)) {
-                                    outer->add_inner_ring(inner);
+                            const osmium::Location testpoint = inner->test_location();
+                            for (size_t i = 0; i < m_outer_rings.size(); ++i) {
+                                if (outer_boxes[i].contains(testpoint) && inner->is_in(m_outer_rings[i])) {
+                                    m_outer_rings[i]->add_inner_ring(inner);
                                     break;
                                 }
                             }
@@ -689,6 +904,7 @@ namespace osmium {
                     }
                 }
 
+                reset();
                 m_segment_list.extract_segments_from_way(way, "outer");
 
                 if (debug()) {
@@ -701,7 +917,9 @@ namespace osmium {
                     osmium::builder::AreaBuilder builder(out_buffer);
                     builder.initialize_from_object(way);
 
-                    if (create_rings()) {
+                    if (is_simple_closed_way(way)) {
+                        create_ring_from_simple_way(way, builder);
+                    } else if (create_rings()) {
                         add_tags_to_area(builder, way);
                         add_rings_to_area(builder);
                     }
@@ -720,6 +938,7 @@ namespace osmium {
                     m_config.problem_reporter->set_object(osmium::item_type::relation, relation.id());
                 }
 
+                reset();
                 m_segment_list.extract_segments_from_ways(relation, members, in_buffer);
 
                 if (debug()) {
@@ -773,8 +992,7 @@ namespace osmium {
 
                 // Now build areas for all ways found in the last step.
                 for (const osmium::Way* way : ways_that_should_be_areas) {
-                    Assembler assembler(m_config);
-                    assembler(*way, out_buffer);
+                    (*this)(*way, out_buffer);
                 }
             }
 
@@ -35,7 +35,12 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <utility>
 #include <vector>
 
 #include <osmium/area/problem_reporter.hpp>
@@ -52,6 +57,92 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Lists of segment indexes attached to the nodes of a segment
+             * tree over a range of leaves. This is used as a helper by the
+             * sweep line algorithm in SegmentList::find_intersections().
+             *
+             * The tree is laid out bottom-up in an array, node 1 is the
+             * root, the leaves are the nodes num_leaves to 2*num_leaves-1.
+             * All lists are stored in one array. The space for each list
+             * has to be reserved up front by calling reserve() for each
+             * entry that will later be added, followed by one call to
+             * commit().
+             */
+            class segment_tree_lists {
+
+                size_t m_num_leaves;
+                std::vector<size_t> m_begin;
+                std::vector<size_t> m_end;
+                std::vector<uint32_t> m_entries;
+
+            public:
+
+                explicit segment_tree_lists(size_t num_leaves) :
+                    m_num_leaves(num_leaves),
+                    m_begin(2 * num_leaves + 1, 0),
+                    m_end(),
+                    m_entries() {
+                }
+
+                /// Call func(node) for the nodes covering the leaves [first, last).
+                template <typename TFunc>
+                void for_each_range_node(size_t first, size_t last, TFunc&& func) const {
+                    for (first += m_num_leaves, last += m_num_leaves; first < last; first >>= 1, last >>= 1) {
+                        if (first & 1) {
+                            func(first++);
+                        }
+                        if (last & 1) {
+                            func(--last);
+                        }
+                    }
+                }
+
+                /// Call func(node) for the given leaf and all its ancestors.
+                template <typename TFunc>
+                void for_each_ancestor(size_t leaf, TFunc&& func) const {
+                    for (leaf += m_num_leaves; leaf > 0; leaf >>= 1) {
+                        func(leaf);
+                    }
+                }
+
+                void reserve(size_t node) {
+                    ++m_begin[node + 1];
+                }
+
+                void commit() {
+                    std::partial_sum(m_begin.begin(), m_begin.end(), m_begin.begin());
+                    m_end.assign(m_begin.begin(), m_begin.end() - 1);
+                    m_entries.resize(m_begin.back());
+                }
+
+                void add(size_t node, uint32_t value) {
+                    assert(m_end[node] < m_begin[node + 1]);
+                    m_entries[m_end[node]++] = value;
+                }
+
+                /**
+                 * Call func(value) for all values in the list of the given
+                 * node. Values for which remove(value) returns true are
+                 * removed from the list instead. The order of the list is
+                 * not kept.
+                 */
+                template <typename TRemove, typename TFunc>
+                void visit(size_t node, TRemove&& remove, TFunc&& func) {
+                    size_t i = m_begin[node];
+                    while (i < m_end[node]) {
+                        const uint32_t value = m_entries[i];
+                        if (remove(value)) {
+                            m_entries[i] = m_entries[--m_end[node]];
+                        } else {
+                            func(value);
+                            ++i;
+                        }
+                    }
+                }
+
+            }; // class segment_tree_lists
+
             /**
              * This is a helper class for the area assembler. It models
              * a list of segments.
@@ -64,6 +155,25 @@ namespace osmium {
 
                 bool m_debug;
 
+                // Index of the segments by y coordinate (see build_y_index()):
+                // The y range of all segments is divided into bands of the
+                // same height. For each band there is a list of the indexes
+                // of all segments overlapping it, sorted by x. The lists are
+                // stored one after the other in m_band_segments.
+                int64_t m_bands_min_y = 0;
+                int64_t m_bands_max_y = -1;
+                int64_t m_band_height = 1;
+                std::vector<uint32_t> m_band_offsets;
+                std::vector<uint32_t> m_band_segments;
+
+                static std::pair<int32_t, int32_t> y_range(const NodeRefSegment& segment) noexcept {
+                    return std::minmax(segment.first().location().y(), segment.second().location().y());
+                }
+
+                size_t band(int64_t y) const noexcept {
+                    return static_cast<size_t>((y - m_bands_min_y) / m_band_height);
+                }
+
             public:
 
                 explicit SegmentList(bool debug) noexcept :
@@ -108,6 +218,10 @@ namespace osmium {
                 /// Clear the list of segments. All segments are removed.
                 void clear() {
                     m_segments.clear();
+                    m_bands_min_y = 0;
+                    m_bands_max_y = -1;
+                    m_band_offsets.clear();
+                    m_band_segments.clear();
                 }
 
                 /// Sort the list of segments.
@@ -115,6 +229,87 @@ namespace osmium {
                     std::sort(m_segments.begin(), m_segments.end());
                 }
 
+                /**
+                 * Build an index of the segments by their y coordinates for
+                 * for_each_segment_left_of(). The segments must be sorted.
+                 * The index is invalidated by any change to the list.
+                 */
+                void build_y_index() {
+                    m_band_offsets.clear();
+                    m_band_segments.clear();
+                    if (m_segments.empty()) {
+                        m_bands_min_y = 0;
+                        m_bands_max_y = -1;
+                        return;
+                    }
+
+                    m_bands_min_y = std::numeric_limits<int32_t>::max();
+                    m_bands_max_y = std::numeric_limits<int32_t>::min();
+                    int64_t sum_heights = 0;
+                    for (const NodeRefSegment& segment : m_segments) {
+                        const auto mm = y_range(segment);
+                        m_bands_min_y = std::min(m_bands_min_y, static_cast<int64_t>(mm.first));
+                        m_bands_max_y = std::max(m_bands_max_y, static_cast<int64_t>(mm.second));
+                        sum_heights += static_cast<int64_t>(mm.second) - mm.first;
+                    }
+
+                    // Use about one band for every four segments, but fewer
+                    // bands if the segments are so long that each one would
+                    // be in more than a few bands on average.
+                    const int64_t height = m_bands_max_y - m_bands_min_y + 1;
+                    const int64_t num_segments = static_cast<int64_t>(m_segments.size());
+                    int64_t num_bands = std::max(num_segments / 4, int64_t(1));
+                    if (sum_heights > 0) {
+                        num_bands = std::max(std::min(num_bands, 7 * num_segments * height / sum_heights), int64_t(1));
+                    }
+                    m_band_height = (height + num_bands - 1) / num_bands;
+                    num_bands = (height + m_band_height - 1) / m_band_height;
+
+                    m_band_offsets.assign(static_cast<size_t>(num_bands) + 1, 0);
+                    for (const NodeRefSegment& segment : m_segments) {
+                        const auto mm = y_range(segment);
+                        for (size_t b = band(mm.first); b <= band(mm.second); ++b) {
+                            ++m_band_offsets[b + 1];
+                        }
+                    }
+                    std::partial_sum(m_band_offsets.begin(), m_band_offsets.end(), m_band_offsets.begin());
+
+                    std::vector<uint32_t> end(m_band_offsets.begin(), m_band_offsets.end() - 1);
+                    m_band_segments.resize(m_band_offsets.back());
+                    for (uint32_t i = 0; i < m_segments.size(); ++i) {
+                        const auto mm = y_range(m_segments[i]);
+                        for (size_t b = band(mm.first); b <= band(mm.second); ++b) {
+                            m_band_segments[end[b]++] = i;
+                        }
+                    }
+                }
+
+                /**
+                 * Call func(segment) for all segments that start left of or
+                 * at the same x coordinate as the given location and whose
+                 * y range (including the end points) contains its y
+                 * coordinate. The index must have been built with
+                 * build_y_index(). Only the segments in the band of the
+                 * location are looked at.
+                 */
+                template <typename TFunc>
+                void for_each_segment_left_of(const osmium::Location& location, TFunc&& func) const {
+                    if (location.y() < m_bands_min_y || location.y() > m_bands_max_y) {
+                        return;
+                    }
+                    const size_t b = band(location.y());
+                    for (uint32_t i = m_band_offsets[b]; i < m_band_offsets[b + 1]; ++i) {
+                        const NodeRefSegment& segment = m_segments[m_band_segments[i]];
+                        if (segment.first().location().x() > location.x()) {
+                            return;
+                        }
+                        const auto mm = y_range(segment);
+                        if (mm.first <= location.y() && location.y() <= mm.second) {
+                            func(segment);
+                        }
+                    }
+                }
+
                 /**
                  * Extract segments from given way and add them to the list.
                  *
@@ -168,20 +363,80 @@ namespace osmium {
                 /**
                  * Find intersection between segments.
                  *
+                 * The segments must be sorted and must not contain
+                 * duplicates (see sort() and erase_duplicate_segments()).
+                 *
+                 * Segments are first checked pairwise, which is fastest for
+                 * the usual small polygons. But this is quadratic if many
+                 * segments overlap in x, for instance on long north-south
+                 * coastlines or boundaries. So if the pairwise check needs
+                 * more than pairwise_checks_per_segment checks per segment,
+                 * it is abandoned and a sweep line algorithm is used instead:
+                 * The segments are processed in order of their smallest x
+                 * coordinate. All segments whose x range overlaps the current
+                 * segment are kept in two segment trees over the y
+                 * coordinates, one indexed by y range, one by smallest y.
+                 * Together they find exactly the segments whose y range
+                 * overlaps the current segment in O(log n) plus the number of
+                 * segments found. Segments are removed lazily once they are
+                 * left of the sweep line. This needs O(n log n) time and
+                 * memory plus the number of segment pairs with overlapping
+                 * bounding boxes.
+                 *
+                 * Both ways find the same intersections and they are reported
+                 * in the same order.
+                 *
                  * @param problem_reporter Any intersections found are reported to this object.
                  * @returns true if there are intersections.
                  */
                 bool find_intersections(osmium::area::ProblemReporter* problem_reporter) const {
-                    if (m_segments.empty()) {
-                        return false;
+                    std::vector<intersection_type> intersections;
+
+                    if (!find_intersections_pairwise(intersections, m_segments.size() * pairwise_checks_per_segment)) {
+                        intersections.clear();
+                        find_intersections_sweep(intersections);
                     }
 
-                    bool found_intersections = false;
+                    for (const auto& intersection : intersections) {
+                        const NodeRefSegment& s1 = m_segments[intersection.first];
+                        const NodeRefSegment& s2 = m_segments[intersection.second];
+                        if (m_debug) {
+                            std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection.location << "\n";
+                        }
+                        if (problem_reporter) {
+                            problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(), s2.way()->id(), s2.first().location(), s2.second().location(), intersection.location);
+                        }
+                    }
+
+                    return !intersections.empty();
+                }
+
+            private:
+
+                /**
+                 * Average number of segment pairs per segment the pairwise
+                 * check may look at before the sweep line algorithm is used.
+                 */
+                static constexpr size_t pairwise_checks_per_segment = 32;
 
-                    for (auto it1 = m_segments.begin(); it1 != m_segments.end()-1; ++it1) {
-                        const NodeRefSegment& s1 = *it1;
-                        for (auto it2 = it1+1; it2 != m_segments.end(); ++it2) {
-                            const NodeRefSegment& s2 = *it2;
+                struct intersection_type {
+                    uint32_t first;
+                    uint32_t second;
+                    osmium::Location location;
+                };
+
+                /**
+                 * Check segments pairwise. Gives up after max_checks checks.
+                 *
+                 * @returns false if it gave up.
+                 */
+                bool find_intersections_pairwise(std::vector<intersection_type>& intersections, size_t max_checks) const {
+                    const uint32_t num_segments = static_cast<uint32_t>(m_segments.size());
+
+                    for (uint32_t i = 0; i + 1 < num_segments; ++i) {
+                        const NodeRefSegment& s1 = m_segments[i];
+                        for (uint32_t j = i + 1; j < num_segments; ++j) {
+                            const NodeRefSegment& s2 = m_segments[j];
 
                             assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
 
@@ -189,22 +444,96 @@ namespace osmium {
                                 break;
                             }
 
+                            if (max_checks-- == 0) {
+                                return false;
+                            }
+
                             if (y_range_overlap(s1, s2)) {
                                 osmium::Location intersection = calculate_intersection(s1, s2);
                                 if (intersection) {
-                                    found_intersections = true;
-                                    if (m_debug) {
-                                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
-                                    }
-                                    if (problem_reporter) {
-                                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(), s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
-                                    }
+                                    intersections.push_back(intersection_type{i, j, intersection});
                                 }
                             }
                         }
                     }
 
-                    return found_intersections;
+                    return true;
+                }
+
+                void find_intersections_sweep(std::vector<intersection_type>& intersections) const {
+                    const uint32_t num_segments = static_cast<uint32_t>(m_segments.size());
+
+                    // Map y coordinates to leaves of the segment trees.
+                    std::vector<int32_t> ys;
+                    ys.reserve(2 * m_segments.size());
+                    for (const NodeRefSegment& segment : m_segments) {
+                        ys.push_back(segment.first().location().y());
+                        ys.push_back(segment.second().location().y());
+                    }
+                    std::sort(ys.begin(), ys.end());
+                    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+                    std::vector<std::pair<size_t, size_t>> y_leaves;
+                    y_leaves.reserve(m_segments.size());
+                    for (const NodeRefSegment& segment : m_segments) {
+                        const std::pair<int32_t, int32_t> mm = std::minmax(segment.first().location().y(), segment.second().location().y());
+                        y_leaves.emplace_back(std::lower_bound(ys.begin(), ys.end(), mm.first) - ys.begin(),
+                                              std::lower_bound(ys.begin(), ys.end(), mm.second) - ys.begin());
+                    }
+
+                    // Segments indexed by their y range...
+                    segment_tree_lists by_range{ys.size()};
+                    // ...and by their smallest y coordinate.
+                    segment_tree_lists by_start{ys.size()};
+
+                    for (const auto& leaves : y_leaves) {
+                        by_range.for_each_range_node(leaves.first, leaves.second + 1, [&by_range](size_t node) {
+                            by_range.reserve(node);
+                        });
+                        by_start.for_each_ancestor(leaves.first, [&by_start](size_t node) {
+                            by_start.reserve(node);
+                        });
+                    }
+                    by_range.commit();
+                    by_start.commit();
+
+                    for (uint32_t n = 0; n < num_segments; ++n) {
+                        const NodeRefSegment& s2 = m_segments[n];
+                        const auto& leaves = y_leaves[n];
+
+                        const auto left_of_sweep_line = [this, &s2](uint32_t i) {
+                            return outside_x_range(s2, m_segments[i]);
+                        };
+                        const auto check = [this, &s2, n, &intersections](uint32_t i) {
+                            const NodeRefSegment& s1 = m_segments[i];
+                            assert(s1 != s2); // erase_duplicate_segments() should have made sure of that
+                            osmium::Location intersection = calculate_intersection(s1, s2);
+                            if (intersection) {
+                                intersections.push_back(intersection_type{i, n, intersection});
+                            }
+                        };
+
+                        // Segments whose y range contains the smallest y of
+                        // this segment...
+                        by_range.for_each_ancestor(leaves.first, [&](size_t node) {
+                            by_range.visit(node, left_of_sweep_line, check);
+                        });
+                        // ...and segments starting inside its y range.
+                        by_start.for_each_range_node(leaves.first + 1, leaves.second + 1, [&](size_t node) {
+                            by_start.visit(node, left_of_sweep_line, check);
+                        });
+
+                        by_range.for_each_range_node(leaves.first, leaves.second + 1, [&by_range, n](size_t node) {
+                            by_range.add(node, n);
+                        });
+                        by_start.for_each_ancestor(leaves.first, [&by_start, n](size_t node) {
+                            by_start.add(node, n);
+                        });
+                    }
+
+                    std::sort(intersections.begin(), intersections.end(), [](const intersection_type& a, const intersection_type& b) {
+                        return a.first < b.first || (a.first == b.first && a.second < b.second);
+                    });
                 }
 
             }; // class SegmentList
@@ -35,8 +35,15 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <osmium/memory/buffer.hpp>
@@ -48,6 +55,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/way.hpp>
 #include <osmium/relations/collector.hpp>
 #include <osmium/relations/detail/member_meta.hpp>
+#include <osmium/thread/pool.hpp>
 
 namespace osmium {
 
@@ -67,7 +75,8 @@ namespace osmium {
          * osmium::relations::Collector.
          *
          * The actual assembling of the areas is done by the assembler
-         * class given as template argument.
+         * class given as template argument. An assembler object is
+         * used for many ways and relations one after the other.
          *
          * @tparam TAssembler Multipolygon Assembler class.
          */
@@ -79,11 +88,93 @@ namespace osmium {
             typedef typename TAssembler::config_type assembler_config_type;
             const assembler_config_type m_assembler_config;
 
+            // The assembler is reused for all objects assembled in this
+            // thread, so that it can keep its internal storage.
+            TAssembler m_assembler;
+
+            // Offsets of the members of the relation being completed.
+            std::vector<size_t> m_member_offsets;
+
             osmium::memory::Buffer m_output_buffer;
 
             static constexpr size_t initial_output_buffer_size = 1024 * 1024;
             static constexpr size_t max_buffer_size_for_flush = 100 * 1024;
 
+            /**
+             * Ways and relations (with their member ways) to be assembled
+             * by one task on the thread pool. The objects are copied into
+             * the batch, so that the task doesn't need access to the
+             * buffers of the collector.
+             */
+            struct assembly_batch {
+
+                struct job {
+                    size_t offset;
+                    size_t first_member;
+                    size_t num_members;
+                };
+
+                osmium::memory::Buffer buffer;
+                std::vector<job> jobs;
+                std::vector<size_t> member_offsets;
+
+                assembly_batch() :
+                    buffer(batch_buffer_size, osmium::memory::Buffer::auto_grow::yes),
+                    jobs(),
+                    member_offsets() {
+                }
+
+            }; // struct assembly_batch
+
+            // Pool task assembling all objects in a batch. Returns a buffer
+            // with the areas in the same order as the objects in the batch.
+            class batch_assembler {
+
+                assembler_config_type m_config;
+                std::shared_ptr<assembly_batch> m_batch;
+
+            public:
+
+                batch_assembler(const assembler_config_type& config, std::shared_ptr<assembly_batch> batch) :
+                    m_config(config),
+                    m_batch(std::move(batch)) {
+                }
+
+                osmium::memory::Buffer operator()() const {
+                    osmium::memory::Buffer out_buffer(initial_output_buffer_size, osmium::memory::Buffer::auto_grow::yes);
+                    const osmium::memory::Buffer& in_buffer = m_batch->buffer;
+                    std::vector<size_t> members;
+                    TAssembler assembler(m_config);
+                    for (const auto& job : m_batch->jobs) {
+                        const auto& item = in_buffer.get<osmium::memory::Item>(job.offset);
+                        try {
+                            if (item.type() == osmium::item_type::way) {
+                                assembler(static_cast<const osmium::Way&>(item), out_buffer);
+                            } else {
+                                const auto begin = m_batch->member_offsets.cbegin() + static_cast<std::ptrdiff_t>(job.first_member);
+                                members.assign(begin, begin + static_cast<std::ptrdiff_t>(job.num_members));
+                                assembler(static_cast<const osmium::Relation&>(item), members, in_buffer, out_buffer);
+                            }
+                        } catch (osmium::invalid_location&) {
+                            // XXX ignore
+                        }
+                    }
+                    return out_buffer;
+                }
+
+            }; // class batch_assembler
+
+            // Used if use_pool_threads() was called.
+            bool m_use_pool_threads = false;
+            bool m_deterministic = true;
+            std::shared_ptr<assembly_batch> m_batch;
+            std::deque<std::future<osmium::memory::Buffer>> m_tasks;
+            std::unordered_map<size_t, size_t> m_copied_members;
+
+            // Size of the objects in a batch after which it is handed to
+            // the thread pool.
+            static constexpr size_t batch_buffer_size = 512 * 1024;
+
             void flush_output_buffer() {
                 if (this->callback()) {
                     osmium::memory::Buffer buffer(initial_output_buffer_size);
@@ -99,11 +190,107 @@ namespace osmium {
                 }
             }
 
+            void add_task_result(std::future<osmium::memory::Buffer>& task) {
+                const osmium::memory::Buffer areas = task.get(); // rethrows exceptions from the task
+                m_output_buffer.add_buffer(areas);
+                m_output_buffer.commit();
+                possibly_flush_output_buffer();
+            }
+
+            // Add the areas from finished tasks to the output buffer. If
+            // the output doesn't have to be deterministic, tasks can
+            // finish in any order, otherwise only tasks that finished
+            // after all tasks submitted before them are used.
+            void add_finished_task_results() {
+                for (auto it = m_tasks.begin(); it != m_tasks.end();) {
+                    if (it->wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                        add_task_result(*it);
+                        it = m_tasks.erase(it);
+                    } else if (m_deterministic) {
+                        return;
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+
+            void wait_for_tasks() {
+                submit_batch();
+                while (!m_tasks.empty()) {
+                    add_task_result(m_tasks.front());
+                    m_tasks.pop_front();
+                }
+            }
+
+            void submit_batch() {
+                if (!m_batch || m_batch->jobs.empty()) {
+                    return;
+                }
+                auto& pool = osmium::thread::Pool::instance();
+                m_tasks.push_back(pool.submit(batch_assembler{m_assembler_config, std::move(m_batch)}));
+                m_batch.reset();
+
+                add_finished_task_results();
+
+                // Don't let too many batches pile up, they need memory.
+                const size_t max_tasks = 2 * static_cast<size_t>(pool.num_threads());
+                while (m_tasks.size() > max_tasks) {
+                    add_task_result(m_tasks.front());
+                    m_tasks.pop_front();
+                    add_finished_task_results();
+                }
+            }
+
+            assembly_batch& current_batch() {
+                if (!m_batch) {
+                    m_batch = std::make_shared<assembly_batch>();
+                }
+                return *m_batch;
+            }
+
+            void add_way_to_batch(const osmium::Way& way) {
+                auto& batch = current_batch();
+                batch.buffer.add_item(way);
+                batch.jobs.push_back({batch.buffer.commit(), 0, 0});
+                if (batch.buffer.committed() >= batch_buffer_size) {
+                    submit_batch();
+                }
+            }
+
+            void add_relation_to_batch(const osmium::Relation& relation, const std::vector<size_t>& offsets) {
+                auto& batch = current_batch();
+                batch.buffer.add_item(relation);
+                const size_t offset = batch.buffer.commit();
+                const size_t first_member = batch.member_offsets.size();
+
+                // A way can be in a relation several times, it is only
+                // copied once, so that the assembler sees the same object.
+                m_copied_members.clear();
+                for (const size_t member_offset : offsets) {
+                    const auto it = m_copied_members.find(member_offset);
+                    if (it != m_copied_members.end()) {
+                        batch.member_offsets.push_back(it->second);
+                    } else {
+                        batch.buffer.add_item(this->members_buffer().template get<osmium::memory::Item>(member_offset));
+                        const size_t copy_offset = batch.buffer.commit();
+                        m_copied_members.emplace(member_offset, copy_offset);
+                        batch.member_offsets.push_back(copy_offset);
+                    }
+                }
+
+                batch.jobs.push_back({offset, first_member, offsets.size()});
+                if (batch.buffer.committed() >= batch_buffer_size) {
+                    submit_batch();
+                }
+            }
+
         public:
 
             explicit MultipolygonCollector(const assembler_config_type& assembler_config) :
                 collector_type(),
                 m_assembler_config(assembler_config),
+                m_assembler(assembler_config),
+                m_member_offsets(),
                 m_output_buffer(initial_output_buffer_size, osmium::memory::Buffer::auto_grow::yes) {
             }
 
@@ -153,8 +340,11 @@ namespace osmium {
                     }
                     if (way.ends_have_same_location()) {
                         // way is closed and has enough nodes, build simple multipolygon
-                        TAssembler assembler(m_assembler_config);
-                        assembler(way, m_output_buffer);
+                        if (m_use_pool_threads) {
+                            add_way_to_batch(way);
+                            return;
+                        }
+                        m_assembler(way, m_output_buffer);
                         possibly_flush_output_buffer();
                     }
                 } catch (osmium::invalid_location&) {
@@ -164,26 +354,61 @@ namespace osmium {
 
             void complete_relation(osmium::relations::RelationMeta& relation_meta) {
                 const osmium::Relation& relation = this->get_relation(relation_meta);
-                std::vector<size_t> offsets;
+                m_member_offsets.clear();
                 for (const auto& member : relation.members()) {
                     if (member.ref() != 0) {
-                        offsets.push_back(this->get_offset(member.type(), member.ref()));
+                        m_member_offsets.push_back(this->get_offset(member.type(), member.ref()));
                     }
                 }
+                if (m_use_pool_threads) {
+                    add_relation_to_batch(relation, m_member_offsets);
+                    return;
+                }
                 try {
-                    TAssembler assembler(m_assembler_config);
-                    assembler(relation, offsets, this->members_buffer(), m_output_buffer);
+                    m_assembler(relation, m_member_offsets, this->members_buffer(), m_output_buffer);
                     possibly_flush_output_buffer();
                 } catch (osmium::invalid_location&) {
                     // XXX ignore
                 }
             }
 
+            /**
+             * Assemble the areas in tasks on the thread pool instead of
+             * in the thread calling the handler. Ways and relations are
+             * collected into batches which are assembled by one task
+             * each. The areas are added to the output when the tasks are
+             * done, so they are usually delivered later than otherwise.
+             * Call flush() (it is called by osmium::apply() at the end)
+             * or read() to get all of them.
+             *
+             * This can't be used with a problem reporter, because the
+             * tasks would call it from several threads at the same time.
+             *
+             * @param deterministic If this is true (the default), the
+             *        areas are output in the same order as without
+             *        using the pool. Otherwise, the areas from batches
+             *        finished early can overtake those from batches with
+             *        large relations, which can be faster.
+             *
+             * @throws std::invalid_argument if a problem reporter is set
+             *         in the assembler config.
+             */
+            void use_pool_threads(bool deterministic = true) {
+                if (m_assembler_config.problem_reporter) {
+                    throw std::invalid_argument("can't assemble areas on the thread pool with a problem reporter");
+                }
+                m_use_pool_threads = true;
+                m_deterministic = deterministic;
+            }
+
             void flush() {
+                wait_for_tasks();
                 flush_output_buffer();
             }
 
             osmium::memory::Buffer read() {
+                wait_for_tasks();
+
                 osmium::memory::Buffer buffer(initial_output_buffer_size, osmium::memory::Buffer::auto_grow::yes);
 
                 using std::swap;
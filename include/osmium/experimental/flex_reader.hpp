@@ -33,17 +33,23 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <atomic>
+#include <exception>
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <osmium/area/assembler.hpp>
 #include <osmium/area/multipolygon_collector.hpp>
 #include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/io/reader.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/util.hpp>
 #include <osmium/visitor.hpp>
 
 namespace osmium {
@@ -53,6 +59,21 @@ namespace osmium {
      */
     namespace experimental {
 
+        /**
+         * Reader adding node locations to ways and optionally creating
+         * areas from closed ways and multipolygon relations.
+         *
+         * The work is done in a pipeline of threads: One thread gets the
+         * buffers from the reader and adds the node locations to the
+         * ways, another one hands the ways to the multipolygon collector,
+         * which assembles the areas on the thread pool. The finished
+         * buffers are queued for read(). While the FlexReader is open,
+         * the location handler must not be used from anywhere else.
+         *
+         * Areas are added to the buffers when they are finished, which
+         * can be some buffers after the ways they were made from. The
+         * last areas come in an extra buffer at the end.
+         */
         template <typename TLocationHandler>
         class FlexReader {
 
@@ -62,9 +83,120 @@ namespace osmium {
             TLocationHandler& m_location_handler;
 
             osmium::io::Reader m_reader;
+            osmium::io::Header m_header;
             osmium::area::Assembler::config_type m_assembler_config;
             osmium::area::MultipolygonCollector<osmium::area::Assembler> m_collector;
 
+            // Set by close() to make the threads stop early.
+            std::atomic<bool> m_stop {false};
+
+            // Buffers with node locations added to the ways.
+            osmium::io::detail::future_buffer_queue_type m_locations_queue;
+
+            // Buffers with areas added, only used if m_with_areas is set.
+            osmium::io::detail::future_buffer_queue_type m_areas_queue;
+
+            osmium::io::detail::queue_wrapper<osmium::memory::Buffer> m_output_queue_wrapper;
+
+            bool m_eof = false;
+
+            osmium::thread::thread_handler m_locations_thread;
+            osmium::thread::thread_handler m_areas_thread;
+
+            static constexpr size_t max_queue_size = 20;
+
+            // Passes all ways to the second pass handler of the collector,
+            // but not the flush() call osmium::apply() makes at the end of
+            // every buffer, so that the area assembly is not waited for.
+            class ways_to_collector {
+
+                typedef osmium::area::MultipolygonCollector<osmium::area::Assembler> collector_type;
+
+                collector_type& m_collector;
+                collector_type::HandlerPass2& m_handler;
+
+            public:
+
+                ways_to_collector(collector_type& collector,
+                                  const std::function<void(osmium::memory::Buffer&&)>& callback) :
+                    m_collector(collector),
+                    m_handler(collector.handler(callback)) {
+                }
+
+                void operator()(const osmium::memory::Buffer& buffer) {
+                    for (const auto& item : buffer) {
+                        if (item.type() == osmium::item_type::way) {
+                            m_handler.way(static_cast<const osmium::Way&>(item));
+                        }
+                    }
+                }
+
+                void flush() {
+                    m_collector.flush();
+                }
+
+            }; // class ways_to_collector
+
+            // This function will run in a separate thread.
+            void locations_thread() {
+                osmium::thread::set_thread_name("_osmium_flex_loc");
+                try {
+                    while (!m_stop) {
+                        osmium::memory::Buffer buffer = m_reader.read();
+                        if (!buffer) {
+                            break;
+                        }
+                        m_location_handler.process_buffer(buffer);
+                        osmium::io::detail::add_to_queue(m_locations_queue, std::move(buffer));
+                    }
+                    m_location_handler.flush();
+                    osmium::io::detail::add_end_of_data_to_queue(m_locations_queue);
+                } catch (...) {
+                    osmium::io::detail::add_to_queue<osmium::memory::Buffer>(m_locations_queue, std::current_exception());
+                    osmium::io::detail::add_end_of_data_to_queue(m_locations_queue);
+                }
+            }
+
+            // This function will run in a separate thread.
+            void areas_thread() {
+                osmium::thread::set_thread_name("_osmium_flex_area");
+                osmium::io::detail::queue_wrapper<osmium::memory::Buffer> input(m_locations_queue);
+                try {
+                    std::vector<osmium::memory::Buffer> area_buffers;
+                    ways_to_collector collector{m_collector, [&area_buffers](osmium::memory::Buffer&& area_buffer) {
+                        area_buffers.push_back(std::move(area_buffer));
+                    }};
+                    while (true) {
+                        osmium::memory::Buffer buffer = input.pop();
+                        if (!buffer) {
+                            break;
+                        }
+                        if (!m_stop) {
+                            collector(buffer);
+                            for (const osmium::memory::Buffer& b : area_buffers) {
+                                buffer.add_buffer(b);
+                                buffer.commit();
+                            }
+                            area_buffers.clear();
+                        }
+                        osmium::io::detail::add_to_queue(m_areas_queue, std::move(buffer));
+                    }
+                    if (!m_stop) {
+                        collector.flush();
+                        for (auto& b : area_buffers) {
+                            if (b.committed() > 0) {
+                                osmium::io::detail::add_to_queue(m_areas_queue, std::move(b));
+                            }
+                        }
+                    }
+                    osmium::io::detail::add_end_of_data_to_queue(m_areas_queue);
+                } catch (...) {
+                    osmium::io::detail::add_to_queue<osmium::memory::Buffer>(m_areas_queue, std::current_exception());
+                    input.drain();
+                    osmium::io::detail::add_end_of_data_to_queue(m_areas_queue);
+                }
+            }
+
         public:
 
             explicit FlexReader(const osmium::io::File& file, TLocationHandler& location_handler, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
@@ -72,14 +204,27 @@ namespace osmium {
                 m_entities((entities & ~osmium::osm_entity_bits::area) | (m_with_areas ? osmium::osm_entity_bits::node | osmium::osm_entity_bits::way : osmium::osm_entity_bits::nothing)),
                 m_location_handler(location_handler),
                 m_reader(file, m_entities),
+                m_header(),
                 m_assembler_config(),
-                m_collector(m_assembler_config)
+                m_collector(m_assembler_config),
+                m_locations_queue(max_queue_size, "flex_locations"),
+                m_areas_queue(max_queue_size, "flex_areas"),
+                m_output_queue_wrapper(m_with_areas ? m_areas_queue : m_locations_queue),
+                m_locations_thread(),
+                m_areas_thread()
             {
                 m_location_handler.ignore_errors();
+                m_location_handler.use_pool_threads_for_nodes();
                 if (m_with_areas) {
                     osmium::io::Reader reader(file, osmium::osm_entity_bits::relation);
                     m_collector.read_relations(reader);
                     reader.close();
+                    m_collector.use_pool_threads();
+                }
+                m_header = m_reader.header();
+                m_locations_thread = osmium::thread::thread_handler{&FlexReader::locations_thread, this};
+                if (m_with_areas) {
+                    m_areas_thread = osmium::thread::thread_handler{&FlexReader::areas_thread, this};
                 }
             }
 
@@ -91,37 +236,52 @@ namespace osmium {
                 FlexReader(osmium::io::File(filename), location_handler, entities) {
             }
 
+            FlexReader(const FlexReader&) = delete;
+            FlexReader& operator=(const FlexReader&) = delete;
+
+            ~FlexReader() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * Read the next buffer. An invalid buffer signals end-of-file.
+             *
+             * @throws Some form of osmium::io_error or other exception
+             *         from the reader or the location handler.
+             */
             osmium::memory::Buffer read() {
-                osmium::memory::Buffer buffer = m_reader.read();
-
-                if (buffer) {
-                    if (m_with_areas) {
-                        std::vector<osmium::memory::Buffer> area_buffers;
-                        osmium::apply(buffer, m_location_handler, m_collector.handler([&area_buffers](osmium::memory::Buffer&& area_buffer) {
-                            area_buffers.push_back(std::move(area_buffer));
-                        }));
-                        for (const osmium::memory::Buffer& b : area_buffers) {
-                            buffer.add_buffer(b);
-                            buffer.commit();
-                        }
-                    } else if (m_entities & (osmium::osm_entity_bits::node | osmium::osm_entity_bits::way)) {
-                        osmium::apply(buffer, m_location_handler);
+                if (m_eof) {
+                    return osmium::memory::Buffer{};
+                }
+                try {
+                    osmium::memory::Buffer buffer = m_output_queue_wrapper.pop();
+                    if (!buffer) {
+                        m_eof = true;
                     }
+                    return buffer;
+                } catch (...) {
+                    m_eof = true;
+                    throw;
                 }
-
-                return buffer;
             }
 
             osmium::io::Header header() {
-                return m_reader.header();
+                return m_header;
             }
 
             void close() {
-                return m_reader.close();
+                m_stop = true;
+                m_output_queue_wrapper.drain();
+                m_eof = true;
+                m_reader.close();
             }
 
             bool eof() const {
-                return m_reader.eof();
+                return m_eof;
             }
 
             const osmium::area::MultipolygonCollector<osmium::area::Assembler>& collector() const {
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cmath>
 #include <iosfwd>
 #include <string>
 
@@ -54,6 +55,14 @@ namespace osmium {
             Coordinates(const osmium::Location& location) : x(location.lon()), y(location.lat()) {
             }
 
+            /**
+             * Are both coordinates finite? The proj library sets points it
+             * can't transform to HUGE_VAL.
+             */
+            bool valid() const noexcept {
+                return std::isfinite(x) && std::isfinite(y);
+            }
+
             void append_to_string(std::string& s, const char infix, int precision) const {
                 osmium::util::double2string(s, x, precision);
                 s += infix;
@@ -37,6 +37,7 @@ DEALINGS IN THE SOFTWARE.
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/memory/collection.hpp>
@@ -139,28 +140,83 @@ namespace osmium {
 
         }; // class IdentityProjection
 
+        /**
+         * Project all locations in the range [begin, end) and write the
+         * results to out, which must have space for as many coordinates.
+         *
+         * This generic version calls the projection for each location.
+         * Projections that can work more efficiently on many locations at
+         * once have overloads of this function. The GeometryFactory always
+         * projects all points of a linestring or ring through this.
+         */
+        template <typename TProjection>
+        inline void project_locations(const TProjection& projection, const osmium::Location* begin, const osmium::Location* end, Coordinates* out) {
+            for (; begin != end; ++begin, ++out) {
+                *out = projection(*begin);
+            }
+        }
+
+        inline void project_locations(const IdentityProjection& /*projection*/, const osmium::Location* begin, const osmium::Location* end, Coordinates* out) {
+            for (; begin != end; ++begin, ++out) {
+                out->x = begin->lon();
+                out->y = begin->lat();
+            }
+        }
+
         /**
          * Geometry factory.
          */
         template <typename TGeomImpl, typename TProjection = IdentityProjection>
         class GeometryFactory {
 
+            TProjection m_projection;
+            TGeomImpl m_impl;
+
+            // Locations of the linestring or ring being created and their
+            // projected coordinates. The vectors are reused for all
+            // geometries.
+            std::vector<osmium::Location> m_locations;
+            std::vector<Coordinates> m_coordinates;
+
+            template <typename TIter>
+            void collect_locations(TIter it, TIter end) {
+                m_locations.clear();
+                for (; it != end; ++it) {
+                    m_locations.push_back(it->location());
+                }
+            }
+
+            template <typename TIter>
+            void collect_unique_locations(TIter it, TIter end) {
+                m_locations.clear();
+                osmium::Location last_location;
+                for (; it != end; ++it) {
+                    if (last_location != it->location()) {
+                        last_location = it->location();
+                        m_locations.push_back(last_location);
+                    }
+                }
+            }
+
+            /**
+             * Project all collected locations in one go into m_coordinates.
+             */
+            void project_collected_locations() {
+                m_coordinates.resize(m_locations.size(), Coordinates{0.0, 0.0});
+                project_locations(m_projection, m_locations.data(), m_locations.data() + m_locations.size(), m_coordinates.data());
+            }
+
             /**
              * Add all points of an outer or inner ring to a multipolygon.
              */
             void add_points(const osmium::OuterRing& nodes) {
-                osmium::Location last_location;
-                for (const osmium::NodeRef& node_ref : nodes) {
-                    if (last_location != node_ref.location()) {
-                        last_location = node_ref.location();
-                        m_impl.multipolygon_add_location(m_projection(last_location));
-                    }
+                collect_unique_locations(nodes.cbegin(), nodes.cend());
+                project_collected_locations();
+                for (const auto& coordinates : m_coordinates) {
+                    m_impl.multipolygon_add_location(coordinates);
                 }
             }
 
-            TProjection m_projection;
-            TGeomImpl m_impl;
-
         public:
 
             /**
@@ -169,7 +225,9 @@ namespace osmium {
             template <typename... TArgs>
             explicit GeometryFactory<TGeomImpl, TProjection>(TArgs&&... args) :
                 m_projection(),
-                m_impl(std::forward<TArgs>(args)...) {
+                m_impl(std::forward<TArgs>(args)...),
+                m_locations(),
+                m_coordinates() {
             }
 
             /**
@@ -179,7 +237,9 @@ namespace osmium {
             template <typename... TArgs>
             explicit GeometryFactory<TGeomImpl, TProjection>(TProjection&& projection, TArgs&&... args) :
                 m_projection(std::move(projection)),
-                m_impl(std::forward<TArgs>(args)...) {
+                m_impl(std::forward<TArgs>(args)...),
+                m_locations(),
+                m_coordinates() {
             }
 
             typedef TProjection projection_type;
@@ -229,25 +289,22 @@ namespace osmium {
 
             template <typename TIter>
             size_t fill_linestring(TIter it, TIter end) {
-                size_t num_points = 0;
-                for (; it != end; ++it, ++num_points) {
-                    m_impl.linestring_add_location(m_projection(it->location()));
+                collect_locations(it, end);
+                project_collected_locations();
+                for (const auto& coordinates : m_coordinates) {
+                    m_impl.linestring_add_location(coordinates);
                 }
-                return num_points;
+                return m_coordinates.size();
             }
 
             template <typename TIter>
             size_t fill_linestring_unique(TIter it, TIter end) {
-                size_t num_points = 0;
-                osmium::Location last_location;
-                for (; it != end; ++it) {
-                    if (last_location != it->location()) {
-                        last_location = it->location();
-                        m_impl.linestring_add_location(m_projection(last_location));
-                        ++num_points;
-                    }
+                collect_unique_locations(it, end);
+                project_collected_locations();
+                for (const auto& coordinates : m_coordinates) {
+                    m_impl.linestring_add_location(coordinates);
                 }
-                return num_points;
+                return m_coordinates.size();
             }
 
             linestring_type linestring_finish(size_t num_points) {
@@ -303,25 +360,22 @@ namespace osmium {
 
             template <typename TIter>
             size_t fill_polygon(TIter it, TIter end) {
-                size_t num_points = 0;
-                for (; it != end; ++it, ++num_points) {
-                    m_impl.polygon_add_location(m_projection(it->location()));
+                collect_locations(it, end);
+                project_collected_locations();
+                for (const auto& coordinates : m_coordinates) {
+                    m_impl.polygon_add_location(coordinates);
                 }
-                return num_points;
+                return m_coordinates.size();
             }
 
             template <typename TIter>
             size_t fill_polygon_unique(TIter it, TIter end) {
-                size_t num_points = 0;
-                osmium::Location last_location;
-                for (; it != end; ++it) {
-                    if (last_location != it->location()) {
-                        last_location = it->location();
-                        m_impl.polygon_add_location(m_projection(last_location));
-                        ++num_points;
-                    }
+                collect_unique_locations(it, end);
+                project_collected_locations();
+                for (const auto& coordinates : m_coordinates) {
+                    m_impl.polygon_add_location(coordinates);
                 }
-                return num_points;
+                return m_coordinates.size();
             }
 
             polygon_type polygon_finish(size_t num_points) {
@@ -34,11 +34,12 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <cassert>
+#include <cstddef>
 #include <string>
-#include <utility>
 
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/geom/factory.hpp>
+#include <osmium/geom/string_output.hpp>
 
 namespace osmium {
 
@@ -46,20 +47,39 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Geometry factory implementation for GeoJSON.
+             *
+             * @tparam TOutput Output policy: string_output returns each
+             *         geometry as a string, buffer_output appends them to
+             *         a buffer owned by the caller.
+             */
+            template <typename TOutput>
             class GeoJSONFactoryImpl {
 
-                std::string m_str;
+                TOutput m_output;
+                size_t m_start = 0;
                 int m_precision;
 
+                std::string& data() const noexcept {
+                    return m_output.data();
+                }
+
             public:
 
-                typedef std::string point_type;
-                typedef std::string linestring_type;
-                typedef std::string polygon_type;
-                typedef std::string multipolygon_type;
-                typedef std::string ring_type;
+                typedef typename TOutput::result_type point_type;
+                typedef typename TOutput::result_type linestring_type;
+                typedef typename TOutput::result_type polygon_type;
+                typedef typename TOutput::result_type multipolygon_type;
+                typedef typename TOutput::result_type ring_type;
 
                 GeoJSONFactoryImpl(int precision = 7) :
+                    m_output(),
+                    m_precision(precision) {
+                }
+
+                explicit GeoJSONFactoryImpl(std::string& buffer, int precision = 7) :
+                    m_output(buffer),
                     m_precision(precision) {
                 }
 
@@ -67,83 +87,76 @@ namespace osmium {
 
                 // { "type": "Point", "coordinates": [100.0, 0.0] }
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
-                    std::string str {"{\"type\":\"Point\",\"coordinates\":"};
-                    xy.append_to_string(str, '[', ',', ']', m_precision);
-                    str += "}";
-                    return str;
+                    const size_t start = m_output.start();
+                    data() += "{\"type\":\"Point\",\"coordinates\":";
+                    xy.append_to_string(data(), '[', ',', ']', m_precision);
+                    data() += "}";
+                    return m_output.finish(start);
                 }
 
                 /* LineString */
 
                 // { "type": "LineString", "coordinates": [ [100.0, 0.0], [101.0, 1.0] ] }
                 void linestring_start() {
-                    m_str = "{\"type\":\"LineString\",\"coordinates\":[";
+                    m_start = m_output.start();
+                    data() += "{\"type\":\"LineString\",\"coordinates\":[";
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, '[', ',', ']', m_precision);
-                    m_str += ',';
+                    xy.append_to_string(data(), '[', ',', ']', m_precision);
+                    data() += ',';
                 }
 
                 linestring_type linestring_finish(size_t /* num_points */) {
-                    assert(!m_str.empty());
-                    std::string str;
-
-                    using std::swap;
-                    swap(str, m_str);
-
-                    str.back() = ']';
-                    str += "}";
-                    return str;
+                    assert(data().size() > m_start);
+                    data().back() = ']';
+                    data() += "}";
+                    return m_output.finish(m_start);
                 }
 
                 /* MultiPolygon */
 
                 void multipolygon_start() {
-                    m_str = "{\"type\":\"MultiPolygon\",\"coordinates\":[";
+                    m_start = m_output.start();
+                    data() += "{\"type\":\"MultiPolygon\",\"coordinates\":[";
                 }
 
                 void multipolygon_polygon_start() {
-                    m_str += '[';
+                    data() += '[';
                 }
 
                 void multipolygon_polygon_finish() {
-                    m_str += "],";
+                    data() += "],";
                 }
 
                 void multipolygon_outer_ring_start() {
-                    m_str += '[';
+                    data() += '[';
                 }
 
                 void multipolygon_outer_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ']';
+                    assert(data().size() > m_start);
+                    data().back() = ']';
                 }
 
                 void multipolygon_inner_ring_start() {
-                    m_str += ",[";
+                    data() += ",[";
                 }
 
                 void multipolygon_inner_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ']';
+                    assert(data().size() > m_start);
+                    data().back() = ']';
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, '[', ',', ']', m_precision);
-                    m_str += ',';
+                    xy.append_to_string(data(), '[', ',', ']', m_precision);
+                    data() += ',';
                 }
 
                 multipolygon_type multipolygon_finish() {
-                    assert(!m_str.empty());
-                    std::string str;
-
-                    using std::swap;
-                    swap(str, m_str);
-
-                    str.back() = ']';
-                    str += "}";
-                    return str;
+                    assert(data().size() > m_start);
+                    data().back() = ']';
+                    data() += "}";
+                    return m_output.finish(m_start);
                 }
 
             }; // class GeoJSONFactoryImpl
@@ -151,7 +164,15 @@ namespace osmium {
         } // namespace detail
 
         template <typename TProjection = IdentityProjection>
-        using GeoJSONFactory = GeometryFactory<osmium::geom::detail::GeoJSONFactoryImpl, TProjection>;
+        using GeoJSONFactory = GeometryFactory<osmium::geom::detail::GeoJSONFactoryImpl<osmium::geom::detail::string_output>, TProjection>;
+
+        /**
+         * GeoJSON factory appending all geometries to a string owned by the
+         * caller, which is given as first argument to the constructor.
+         * Geometries are returned as osmium::geom::output_range.
+         */
+        template <typename TProjection = IdentityProjection>
+        using GeoJSONBufferFactory = GeometryFactory<osmium::geom::detail::GeoJSONFactoryImpl<osmium::geom::detail::buffer_output>, TProjection>;
 
     } // namespace geom
 
@@ -34,6 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <cmath>
+#include <cstddef>
 #include <string>
 
 #include <osmium/geom/coordinates.hpp>
@@ -103,6 +104,28 @@ namespace osmium {
 
         }; // class MercatorProjection
 
+        /**
+         * Project many locations to Web Mercator. The locations are checked
+         * first, then the x and y coordinates are calculated in separate
+         * simple loops, which the compiler can vectorize.
+         *
+         * @throws osmium::invalid_location if any of the locations is invalid
+         */
+        inline void project_locations(const MercatorProjection& /*projection*/, const osmium::Location* begin, const osmium::Location* end, Coordinates* out) {
+            const size_t size = static_cast<size_t>(end - begin);
+            for (size_t i = 0; i < size; ++i) {
+                if (!begin[i].valid()) {
+                    throw osmium::invalid_location("invalid location");
+                }
+            }
+            for (size_t i = 0; i < size; ++i) {
+                out[i].x = detail::lon_to_x(begin[i].lon_without_check());
+            }
+            for (size_t i = 0; i < size; ++i) {
+                out[i].y = detail::lat_to_y(begin[i].lat_without_check());
+            }
+        }
+
     } // namespace geom
 
 } // namespace osmium
@@ -42,6 +42,7 @@ DEALINGS IN THE SOFTWARE.
  * @attention If you include this file, you'll need to link with `libproj`.
  */
 
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -99,7 +100,7 @@ namespace osmium {
              *
              * Coordinates have to be in radians and are produced in radians.
              *
-             * @throws osmmium::projection_error if the projection fails
+             * @throws osmium::projection_error if the projection fails
              */
             friend Coordinates transform(const CRS& src, const CRS& dest, Coordinates c) {
                 int result = pj_transform(src.get(), dest.get(), 1, 1, &c.x, &c.y, nullptr);
@@ -109,6 +110,33 @@ namespace osmium {
                 return c;
             }
 
+            /**
+             * Transform count coordinates in place from one CRS into
+             * another with a single call to the proj library.
+             *
+             * Coordinates have to be in radians and are produced in radians.
+             *
+             * @throws osmium::projection_error if the projection fails for
+             *         any of the coordinates
+             */
+            friend void transform(const CRS& src, const CRS& dest, Coordinates* coordinates, size_t count) {
+                if (count == 0) {
+                    return;
+                }
+                static_assert(sizeof(Coordinates) == 2 * sizeof(double), "Coordinates must consist of two doubles only");
+                int result = pj_transform(src.get(), dest.get(), static_cast<long>(count), 2, &coordinates->x, &coordinates->y, nullptr);
+                if (result != 0) {
+                    throw osmium::projection_error(std::string("projection failed: ") + pj_strerrno(result));
+                }
+                // When transforming several points, proj marks points it
+                // can't transform instead of returning an error.
+                for (size_t i = 0; i < count; ++i) {
+                    if (!coordinates[i].valid()) {
+                        throw osmium::projection_error("projection failed");
+                    }
+                }
+            }
+
         }; // class CRS
 
         /**
@@ -150,6 +178,32 @@ namespace osmium {
                 return c;
             }
 
+            /**
+             * Project the locations in [begin, end) and write the results
+             * to out. Uses one call to the proj library for all locations.
+             */
+            void operator()(const osmium::Location* begin, const osmium::Location* end, Coordinates* out) const {
+                const size_t count = static_cast<size_t>(end - begin);
+
+                if (m_epsg == 4326) {
+                    for (size_t i = 0; i < count; ++i) {
+                        out[i] = Coordinates{begin[i].lon(), begin[i].lat()};
+                    }
+                    return;
+                }
+
+                for (size_t i = 0; i < count; ++i) {
+                    out[i] = Coordinates{deg_to_rad(begin[i].lon()), deg_to_rad(begin[i].lat())};
+                }
+                transform(m_crs_wgs84, m_crs_user, out, count);
+                if (m_crs_user.is_latlong()) {
+                    for (size_t i = 0; i < count; ++i) {
+                        out[i].x = rad_to_deg(out[i].x);
+                        out[i].y = rad_to_deg(out[i].y);
+                    }
+                }
+            }
+
             int epsg() const noexcept {
                 return m_epsg;
             }
@@ -160,6 +214,10 @@ namespace osmium {
 
         }; // class Projection
 
+        inline void project_locations(const Projection& projection, const osmium::Location* begin, const osmium::Location* end, Coordinates* out) {
+            projection(begin, end, out);
+        }
+
     } // namespace geom
 
 } // namespace osmium
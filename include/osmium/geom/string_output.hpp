@@ -0,0 +1,143 @@
+#ifndef OSMIUM_GEOM_STRING_OUTPUT_HPP
+#define OSMIUM_GEOM_STRING_OUTPUT_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Where a geometry was written into the output buffer of a geometry
+         * factory writing into a caller-owned buffer (such as the
+         * WKBBufferFactory).
+         */
+        struct output_range {
+
+            /// Offset of the first byte of the geometry in the buffer.
+            size_t offset;
+
+            /// Size of the geometry in bytes.
+            size_t size;
+
+        }; // struct output_range
+
+        namespace detail {
+
+            /**
+             * Output policy for the string based geometry factory
+             * implementations returning each geometry as a new string.
+             */
+            class string_output {
+
+                mutable std::string m_data;
+
+            public:
+
+                typedef std::string result_type;
+
+                string_output() :
+                    m_data() {
+                }
+
+                std::string& data() const noexcept {
+                    return m_data;
+                }
+
+                /// Start a new geometry, returns its offset in data().
+                size_t start() const {
+                    m_data.clear();
+                    return 0;
+                }
+
+                /// Finish the geometry started at the offset.
+                result_type finish(size_t /*offset*/) const {
+                    std::string data;
+
+                    using std::swap;
+                    swap(data, m_data);
+
+                    return data;
+                }
+
+            }; // class string_output
+
+            /**
+             * Output policy for the string based geometry factory
+             * implementations appending all geometries to a buffer owned
+             * by the caller. The caller can add other data in between
+             * geometries and can clear the buffer any time it is not in
+             * the middle of creating a geometry. Its capacity is reused,
+             * so no memory has to be allocated for each geometry.
+             *
+             * If creating a geometry fails with an exception, the buffer
+             * might contain a part of the geometry. Truncate it to the size
+             * it had before, if needed.
+             */
+            class buffer_output {
+
+                std::string* m_buffer;
+
+            public:
+
+                typedef osmium::geom::output_range result_type;
+
+                explicit buffer_output(std::string& buffer) noexcept :
+                    m_buffer(&buffer) {
+                }
+
+                std::string& data() const noexcept {
+                    return *m_buffer;
+                }
+
+                size_t start() const noexcept {
+                    return m_buffer->size();
+                }
+
+                result_type finish(size_t offset) const noexcept {
+                    return result_type{offset, m_buffer->size() - offset};
+                }
+
+            }; // class buffer_output
+
+        } // namespace detail
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_STRING_OUTPUT_HPP
@@ -39,6 +39,9 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/geom/factory.hpp>
+#include <osmium/geom/string_output.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/location.hpp>
 #include <osmium/util/cast.hpp>
 #include <osmium/util/endian.hpp>
 
@@ -60,9 +63,7 @@ namespace osmium {
 
             template <typename T>
             inline void str_push(std::string& str, T data) {
-                size_t size = str.size();
-                str.resize(size + sizeof(T));
-                std::copy_n(reinterpret_cast<char*>(&data), sizeof(T), &str[size]);
+                str.append(reinterpret_cast<const char*>(&data), sizeof(T));
             }
 
             inline std::string convert_to_hex(const std::string& str) {
@@ -77,6 +78,41 @@ namespace osmium {
                 return out;
             }
 
+            /**
+             * Convert the part of the string starting at offset to hex in
+             * place.
+             */
+            inline void convert_to_hex(std::string& str, size_t offset) {
+                static const char* lookup_hex = "0123456789ABCDEF";
+                const size_t size = str.size() - offset;
+                str.resize(offset + 2 * size);
+
+                // Back to front, so that no byte is overwritten before it
+                // is converted.
+                for (size_t i = size; i > 0; --i) {
+                    const char c = str[offset + i - 1];
+                    str[offset + 2 * i - 2] = lookup_hex[(c >> 4) & 0xf];
+                    str[offset + 2 * i - 1] = lookup_hex[c & 0xf];
+                }
+            }
+
+            inline size_t wkb_header_size(wkb_type wtype) noexcept {
+                // byte order, geometry type, SRID for EWKB
+                return 1 + sizeof(uint32_t) + (wtype == wkb_type::ewkb ? sizeof(uint32_t) : 0);
+            }
+
+            inline size_t wkb_output_size(size_t size, out_type otype) noexcept {
+                return otype == out_type::hex ? 2 * size : size;
+            }
+
+            /**
+             * Geometry factory implementation for WKB and EWKB.
+             *
+             * @tparam TOutput Output policy: string_output returns each
+             *         geometry as a string, buffer_output appends them to
+             *         a buffer owned by the caller.
+             */
+            template <typename TOutput>
             class WKBFactoryImpl {
 
                 /// OSM data always uses SRID 4326 (WGS84).
@@ -110,11 +146,12 @@ namespace osmium {
                     NDR = 1          // Little Endian
                 }; // enum class wkb_byte_order_type
 
-                std::string m_data;
+                TOutput m_output;
                 uint32_t m_points {0};
                 wkb_type m_wkb_type;
                 out_type m_out_type;
 
+                size_t m_start = 0;
                 size_t m_linestring_size_offset = 0;
                 size_t m_polygons = 0;
                 size_t m_rings = 0;
@@ -122,6 +159,10 @@ namespace osmium {
                 size_t m_polygon_size_offset = 0;
                 size_t m_ring_size_offset = 0;
 
+                std::string& data() const noexcept {
+                    return m_output.data();
+                }
+
                 size_t header(std::string& str, wkbGeometryType type, bool add_length) const {
 #if __BYTE_ORDER == __LITTLE_ENDIAN
                     str_push(str, wkb_byte_order_type::NDR);
@@ -142,18 +183,32 @@ namespace osmium {
                 }
 
                 void set_size(const size_t offset, const size_t size) {
-                    *reinterpret_cast<uint32_t*>(&m_data[offset]) = static_cast_with_assert<uint32_t>(size);
+                    *reinterpret_cast<uint32_t*>(&data()[offset]) = static_cast_with_assert<uint32_t>(size);
+                }
+
+                typename TOutput::result_type finish(size_t start) const {
+                    if (m_out_type == out_type::hex) {
+                        convert_to_hex(data(), start);
+                    }
+                    return m_output.finish(start);
                 }
 
             public:
 
-                typedef std::string point_type;
-                typedef std::string linestring_type;
-                typedef std::string polygon_type;
-                typedef std::string multipolygon_type;
-                typedef std::string ring_type;
+                typedef typename TOutput::result_type point_type;
+                typedef typename TOutput::result_type linestring_type;
+                typedef typename TOutput::result_type polygon_type;
+                typedef typename TOutput::result_type multipolygon_type;
+                typedef typename TOutput::result_type ring_type;
 
                 explicit WKBFactoryImpl(wkb_type wtype = wkb_type::wkb, out_type otype = out_type::binary) :
+                    m_output(),
+                    m_wkb_type(wtype),
+                    m_out_type(otype) {
+                }
+
+                explicit WKBFactoryImpl(std::string& buffer, wkb_type wtype = wkb_type::wkb, out_type otype = out_type::binary) :
+                    m_output(buffer),
                     m_wkb_type(wtype),
                     m_out_type(otype) {
                 }
@@ -161,56 +216,42 @@ namespace osmium {
                 /* Point */
 
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
-                    std::string data;
-                    header(data, wkbPoint, false);
-                    str_push(data, xy.x);
-                    str_push(data, xy.y);
-
-                    if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
-                    } else {
-                        return data;
-                    }
+                    const size_t start = m_output.start();
+                    header(data(), wkbPoint, false);
+                    str_push(data(), xy.x);
+                    str_push(data(), xy.y);
+                    return finish(start);
                 }
 
                 /* LineString */
 
                 void linestring_start() {
-                    m_data.clear();
-                    m_linestring_size_offset = header(m_data, wkbLineString, true);
+                    m_start = m_output.start();
+                    m_linestring_size_offset = header(data(), wkbLineString, true);
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    str_push(m_data, xy.x);
-                    str_push(m_data, xy.y);
+                    str_push(data(), xy.x);
+                    str_push(data(), xy.y);
                 }
 
                 linestring_type linestring_finish(size_t num_points) {
                     set_size(m_linestring_size_offset, num_points);
-                    std::string data;
-
-                    using std::swap;
-                    swap(data, m_data);
-
-                    if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
-                    } else {
-                        return data;
-                    }
+                    return finish(m_start);
                 }
 
                 /* MultiPolygon */
 
                 void multipolygon_start() {
-                    m_data.clear();
+                    m_start = m_output.start();
                     m_polygons = 0;
-                    m_multipolygon_size_offset = header(m_data, wkbMultiPolygon, true);
+                    m_multipolygon_size_offset = header(data(), wkbMultiPolygon, true);
                 }
 
                 void multipolygon_polygon_start() {
                     ++m_polygons;
                     m_rings = 0;
-                    m_polygon_size_offset = header(m_data, wkbPolygon, true);
+                    m_polygon_size_offset = header(data(), wkbPolygon, true);
                 }
 
                 void multipolygon_polygon_finish() {
@@ -220,8 +261,8 @@ namespace osmium {
                 void multipolygon_outer_ring_start() {
                     ++m_rings;
                     m_points = 0;
-                    m_ring_size_offset = m_data.size();
-                    str_push(m_data, static_cast<uint32_t>(0));
+                    m_ring_size_offset = data().size();
+                    str_push(data(), static_cast<uint32_t>(0));
                 }
 
                 void multipolygon_outer_ring_finish() {
@@ -231,8 +272,8 @@ namespace osmium {
                 void multipolygon_inner_ring_start() {
                     ++m_rings;
                     m_points = 0;
-                    m_ring_size_offset = m_data.size();
-                    str_push(m_data, static_cast<uint32_t>(0));
+                    m_ring_size_offset = data().size();
+                    str_push(data(), static_cast<uint32_t>(0));
                 }
 
                 void multipolygon_inner_ring_finish() {
@@ -240,31 +281,75 @@ namespace osmium {
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    str_push(m_data, xy.x);
-                    str_push(m_data, xy.y);
+                    str_push(data(), xy.x);
+                    str_push(data(), xy.y);
                     ++m_points;
                 }
 
                 multipolygon_type multipolygon_finish() {
                     set_size(m_multipolygon_size_offset, m_polygons);
-                    std::string data;
-
-                    using std::swap;
-                    swap(data, m_data);
-
-                    if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
-                    } else {
-                        return data;
-                    }
+                    return finish(m_start);
                 }
 
             }; // class WKBFactoryImpl
 
         } // namespace detail
 
+        /**
+         * Size in bytes of a point in WKB format.
+         */
+        inline size_t wkb_point_size(wkb_type wtype = wkb_type::wkb, out_type otype = out_type::binary) noexcept {
+            return detail::wkb_output_size(detail::wkb_header_size(wtype) + 2 * sizeof(double), otype);
+        }
+
+        /**
+         * Size in bytes of a linestring with the given number of points in
+         * WKB format.
+         */
+        inline size_t wkb_linestring_size(size_t num_points, wkb_type wtype = wkb_type::wkb, out_type otype = out_type::binary) noexcept {
+            return detail::wkb_output_size(detail::wkb_header_size(wtype) + sizeof(uint32_t) + num_points * 2 * sizeof(double), otype);
+        }
+
+        /**
+         * Size in bytes of the multipolygon created from the area in WKB
+         * format.
+         */
+        inline size_t wkb_multipolygon_size(const osmium::Area& area, wkb_type wtype = wkb_type::wkb, out_type otype = out_type::binary) {
+            const size_t polygon_header_size = detail::wkb_header_size(wtype) + sizeof(uint32_t);
+            size_t size = polygon_header_size;
+            for (auto it = area.cbegin(); it != area.cend(); ++it) {
+                if (it->type() == osmium::item_type::outer_ring) {
+                    size += polygon_header_size;
+                } else if (it->type() != osmium::item_type::inner_ring) {
+                    continue;
+                }
+                // same as GeometryFactory: consecutive nodes with the same
+                // location are only used once
+                const osmium::OuterRing& ring = static_cast<const osmium::OuterRing&>(*it);
+                size_t num_points = 0;
+                osmium::Location last_location;
+                for (const osmium::NodeRef& node_ref : ring) {
+                    if (last_location != node_ref.location()) {
+                        last_location = node_ref.location();
+                        ++num_points;
+                    }
+                }
+                size += sizeof(uint32_t) + num_points * 2 * sizeof(double);
+            }
+            return detail::wkb_output_size(size, otype);
+        }
+
+        template <typename TProjection = IdentityProjection>
+        using WKBFactory = GeometryFactory<osmium::geom::detail::WKBFactoryImpl<osmium::geom::detail::string_output>, TProjection>;
+
+        /**
+         * WKB factory appending all geometries to a string owned by the
+         * caller, which is given as first argument to the constructor.
+         * Geometries are returned as osmium::geom::output_range. Use
+         * wkb_point_size() etc. to reserve enough space in the buffer.
+         */
         template <typename TProjection = IdentityProjection>
-        using WKBFactory = GeometryFactory<osmium::geom::detail::WKBFactoryImpl, TProjection>;
+        using WKBBufferFactory = GeometryFactory<osmium::geom::detail::WKBFactoryImpl<osmium::geom::detail::buffer_output>, TProjection>;
 
     } // namespace geom
 
@@ -36,10 +36,10 @@ DEALINGS IN THE SOFTWARE.
 #include <cassert>
 #include <cstddef>
 #include <string>
-#include <utility>
 
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/geom/factory.hpp>
+#include <osmium/geom/string_output.hpp>
 
 namespace osmium {
 
@@ -47,99 +47,111 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Geometry factory implementation for WKT.
+             *
+             * @tparam TOutput Output policy: string_output returns each
+             *         geometry as a string, buffer_output appends them to
+             *         a buffer owned by the caller.
+             */
+            template <typename TOutput>
             class WKTFactoryImpl {
 
-                std::string m_str;
+                TOutput m_output;
+                size_t m_start = 0;
                 int m_precision;
 
+                std::string& data() const noexcept {
+                    return m_output.data();
+                }
+
             public:
 
-                typedef std::string point_type;
-                typedef std::string linestring_type;
-                typedef std::string polygon_type;
-                typedef std::string multipolygon_type;
-                typedef std::string ring_type;
+                typedef typename TOutput::result_type point_type;
+                typedef typename TOutput::result_type linestring_type;
+                typedef typename TOutput::result_type polygon_type;
+                typedef typename TOutput::result_type multipolygon_type;
+                typedef typename TOutput::result_type ring_type;
 
                 WKTFactoryImpl(int precision = 7) :
+                    m_output(),
+                    m_precision(precision) {
+                }
+
+                explicit WKTFactoryImpl(std::string& buffer, int precision = 7) :
+                    m_output(buffer),
                     m_precision(precision) {
                 }
 
                 /* Point */
 
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
-                    std::string str {"POINT"};
-                    xy.append_to_string(str, '(', ' ', ')', m_precision);
-                    return str;
+                    const size_t start = m_output.start();
+                    data() += "POINT";
+                    xy.append_to_string(data(), '(', ' ', ')', m_precision);
+                    return m_output.finish(start);
                 }
 
                 /* LineString */
 
                 void linestring_start() {
-                    m_str = "LINESTRING(";
+                    m_start = m_output.start();
+                    data() += "LINESTRING(";
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, ' ', m_precision);
-                    m_str += ',';
+                    xy.append_to_string(data(), ' ', m_precision);
+                    data() += ',';
                 }
 
                 linestring_type linestring_finish(size_t /* num_points */) {
-                    assert(!m_str.empty());
-                    std::string str;
-
-                    using std::swap;
-                    swap(str, m_str);
-
-                    str.back() = ')';
-                    return str;
+                    assert(data().size() > m_start);
+                    data().back() = ')';
+                    return m_output.finish(m_start);
                 }
 
                 /* MultiPolygon */
 
                 void multipolygon_start() {
-                    m_str = "MULTIPOLYGON(";
+                    m_start = m_output.start();
+                    data() += "MULTIPOLYGON(";
                 }
 
                 void multipolygon_polygon_start() {
-                    m_str += '(';
+                    data() += '(';
                 }
 
                 void multipolygon_polygon_finish() {
-                    m_str += "),";
+                    data() += "),";
                 }
 
                 void multipolygon_outer_ring_start() {
-                    m_str += '(';
+                    data() += '(';
                 }
 
                 void multipolygon_outer_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ')';
+                    assert(data().size() > m_start);
+                    data().back() = ')';
                 }
 
                 void multipolygon_inner_ring_start() {
-                    m_str += ",(";
+                    data() += ",(";
                 }
 
                 void multipolygon_inner_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ')';
+                    assert(data().size() > m_start);
+                    data().back() = ')';
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, ' ', m_precision);
-                    m_str += ',';
+                    xy.append_to_string(data(), ' ', m_precision);
+                    data() += ',';
                 }
 
                 multipolygon_type multipolygon_finish() {
-                    assert(!m_str.empty());
-                    std::string str;
-
-                    using std::swap;
-                    swap(str, m_str);
-
-                    str.back() = ')';
-                    return str;
+                    assert(data().size() > m_start);
+                    data().back() = ')';
+                    return m_output.finish(m_start);
                 }
 
             }; // class WKTFactoryImpl
@@ -147,7 +159,15 @@ namespace osmium {
         } // namespace detail
 
         template <typename TProjection = IdentityProjection>
-        using WKTFactory = GeometryFactory<osmium::geom::detail::WKTFactoryImpl, TProjection>;
+        using WKTFactory = GeometryFactory<osmium::geom::detail::WKTFactoryImpl<osmium::geom::detail::string_output>, TProjection>;
+
+        /**
+         * WKT factory appending all geometries to a string owned by the
+         * caller, which is given as first argument to the constructor.
+         * Geometries are returned as osmium::geom::output_range.
+         */
+        template <typename TProjection = IdentityProjection>
+        using WKTBufferFactory = GeometryFactory<osmium::geom::detail::WKTFactoryImpl<osmium::geom::detail::buffer_output>, TProjection>;
 
     } // namespace geom
 
@@ -33,16 +33,27 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <memory>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <osmium/handler.hpp>
+#include <osmium/index/detail/vector_map.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map/dummy.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <osmium/index/node_locations_map.hpp>
 
@@ -84,6 +95,29 @@ namespace osmium {
 
             bool m_must_sort {false};
 
+            // Scratch space for batched lookups in way() and process_buffer().
+            std::vector<osmium::Way*> m_ways;
+            std::vector<osmium::unsigned_object_id_type> m_pos_ids;
+            std::vector<osmium::unsigned_object_id_type> m_neg_ids;
+            std::vector<osmium::Location> m_pos_locations;
+            std::vector<osmium::Location> m_neg_locations;
+
+            typedef std::vector<std::pair<osmium::unsigned_object_id_type, osmium::Location>> node_batch_type;
+
+            // Used in process_buffer() if use_pool_threads_for_nodes() was
+            // called and the index for positive IDs is a dense map.
+            bool m_use_pool_threads_for_nodes {false};
+            node_batch_type m_node_batch;
+            std::vector<std::future<void>> m_node_tasks;
+
+            // Size the dense index would have if all nodes were stored
+            // with set(). Only valid if m_dense_grown is set.
+            size_t m_dense_size {0};
+
+            // Set if the dense index was made larger than needed, so that
+            // it doesn't have to be resized for every batch of nodes.
+            bool m_dense_grown {false};
+
             // It is okay to have this static dummy instance, even when using several threads,
             // because it is read-only.
             static dummy_type& get_dummy() {
@@ -99,22 +133,341 @@ namespace osmium {
                 m_storage_neg(storage_neg) {
             }
 
+        private:
+
+            // Number of node refs looked up together in process_buffer().
+            static constexpr size_t lookup_batch_size = 1024;
+
+            // Minimum number of node locations stored by one pool task if
+            // use_pool_threads_for_nodes() was called.
+            static constexpr size_t node_batch_size = 64 * 1024;
+
+            // Functor calling process_buffer_impl(). Used with
+            // osmium::index::call_with_concrete_map(), so that it runs
+            // on the concrete type of the index.
+            class buffer_processor {
+
+                NodeLocationsForWays& m_handler;
+                osmium::memory::Buffer& m_buffer;
+
+            public:
+
+                buffer_processor(NodeLocationsForWays& handler, osmium::memory::Buffer& buffer) :
+                    m_handler(handler),
+                    m_buffer(buffer) {
+                }
+
+                template <typename TMap>
+                void operator()(TMap& storage_pos) const {
+                    m_handler.process_buffer_impl(storage_pos, m_buffer);
+                }
+
+            }; // class buffer_processor
+
+            // Pool task storing a batch of node locations in a dense
+            // index in concurrent set mode.
+            template <typename TMap>
+            class node_storer {
+
+                TMap& m_map;
+                std::shared_ptr<node_batch_type> m_batch;
+
+            public:
+
+                node_storer(TMap& map, std::shared_ptr<node_batch_type> batch) :
+                    m_map(map),
+                    m_batch(std::move(batch)) {
+                }
+
+                void operator()() const {
+                    for (const auto& element : *m_batch) {
+                        m_map.set_concurrently(element.first, element.second);
+                    }
+                }
+
+            }; // class node_storer
+
+            // Functor calling finish_node_tasks_impl(). Used with
+            // osmium::index::call_with_concrete_map().
+            class node_tasks_finisher {
+
+                NodeLocationsForWays& m_handler;
+
+            public:
+
+                explicit node_tasks_finisher(NodeLocationsForWays& handler) :
+                    m_handler(handler) {
+                }
+
+                template <typename TMap>
+                void operator()(TMap& storage_pos) const {
+                    m_handler.finish_node_tasks_impl(storage_pos, osmium::index::is_dense_map<TMap>{});
+                }
+
+            }; // class node_tasks_finisher
+
+            void wait_for_node_tasks() {
+                std::vector<std::future<void>> tasks;
+                using std::swap;
+                swap(tasks, m_node_tasks);
+                for (auto& task : tasks) {
+                    task.wait();
+                }
+                for (auto& task : tasks) {
+                    task.get(); // rethrows exceptions from the task
+                }
+            }
+
+            template <typename TMap>
+            void submit_node_batch(TMap& storage_pos, std::true_type) {
+                if (m_node_batch.empty()) {
+                    return;
+                }
+
+                osmium::unsigned_object_id_type max_id = 0;
+                for (const auto& element : m_node_batch) {
+                    max_id = std::max(max_id, element.first);
+                }
+
+                if (!m_dense_grown) {
+                    m_dense_size = storage_pos.size();
+                }
+                m_dense_size = std::max(m_dense_size, static_cast<size_t>(max_id) + 1);
+
+                // Resizing can move the data, so no task may be running
+                // while doing it. Grow by a quarter more than needed, so
+                // that this doesn't happen too often.
+                if (m_dense_size > storage_pos.size()) {
+                    wait_for_node_tasks();
+                    storage_pos.resize(m_dense_size + m_dense_size / 4);
+                    m_dense_grown = true;
+                }
+
+                // forget about tasks that are already done
+                while (!m_node_tasks.empty() &&
+                       m_node_tasks.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    m_node_tasks.front().get();
+                    m_node_tasks.erase(m_node_tasks.begin());
+                }
+
+                auto batch = std::make_shared<node_batch_type>();
+                batch->reserve(node_batch_size);
+                using std::swap;
+                swap(*batch, m_node_batch);
+                m_node_tasks.push_back(osmium::thread::Pool::instance().submit(node_storer<TMap>{storage_pos, std::move(batch)}));
+            }
+
+            template <typename TMap>
+            void submit_node_batch(TMap& /*storage_pos*/, std::false_type) {
+            }
+
+            // Store the remaining batch of nodes, wait for all node_storer
+            // tasks and bring the index into the state it would be in if
+            // set() had been used.
+            template <typename TMap>
+            void finish_node_tasks_impl(TMap& storage_pos, std::true_type) {
+                submit_node_batch(storage_pos, std::true_type{});
+                wait_for_node_tasks();
+                if (m_dense_grown) {
+                    m_dense_grown = false;
+                    storage_pos.resize(m_dense_size);
+                }
+            }
+
+            template <typename TMap>
+            void finish_node_tasks_impl(TMap& /*storage_pos*/, std::false_type) {
+                wait_for_node_tasks();
+            }
+
+            bool node_tasks_pending() const noexcept {
+                return !m_node_batch.empty() || !m_node_tasks.empty() || m_dense_grown;
+            }
+
+            void finish_node_tasks() {
+                if (node_tasks_pending()) {
+                    osmium::index::call_with_concrete_map(m_storage_pos, node_tasks_finisher{*this});
+                }
+            }
+
+            void sort_if_needed() {
+                if (m_must_sort) {
+                    m_storage_pos.sort();
+                    m_storage_neg.sort();
+                    m_must_sort = false;
+                }
+            }
+
+            void clear_lookups() {
+                m_pos_ids.clear();
+                m_neg_ids.clear();
+            }
+
+            void add_lookups(const osmium::Way& way) {
+                for (const auto& node_ref : way.nodes()) {
+                    const osmium::object_id_type id = node_ref.ref();
+                    if (id >= 0) {
+                        m_pos_ids.push_back(static_cast<osmium::unsigned_object_id_type>( id));
+                    } else {
+                        m_neg_ids.push_back(static_cast<osmium::unsigned_object_id_type>(-id));
+                    }
+                }
+            }
+
+            template <typename TMap>
+            void run_lookups(TMap& storage_pos) {
+                sort_if_needed();
+                m_pos_locations.resize(m_pos_ids.size());
+                storage_pos.get_many(m_pos_ids.data(), m_pos_locations.data(), m_pos_ids.size());
+                m_neg_locations.resize(m_neg_ids.size());
+                m_storage_neg.get_many(m_neg_ids.data(), m_neg_locations.data(), m_neg_ids.size());
+            }
+
+            // Set locations from the lookup results, returns false if
+            // there was an error.
+            bool set_locations(osmium::Way& way, size_t& pos_index, size_t& neg_index) {
+                bool okay = true;
+                for (auto& node_ref : way.nodes()) {
+                    const osmium::Location location = node_ref.ref() >= 0 ? m_pos_locations[pos_index++]
+                                                                          : m_neg_locations[neg_index++];
+                    if (location) {
+                        node_ref.set_location(location);
+                    } else {
+                        okay = false;
+                    }
+                }
+                return okay;
+            }
+
+            // Look up locations for all ways collected in m_ways and set
+            // them, returns false if there was an error.
+            template <typename TMap>
+            bool resolve_ways(TMap& storage_pos) {
+                run_lookups(storage_pos);
+
+                bool okay = true;
+                size_t pos_index = 0;
+                size_t neg_index = 0;
+                for (osmium::Way* way : m_ways) {
+                    if (!set_locations(*way, pos_index, neg_index)) {
+                        okay = false;
+                    }
+                }
+
+                m_ways.clear();
+                clear_lookups();
+
+                return okay;
+            }
+
+            template <typename TMap>
+            void process_buffer_impl(TMap& storage_pos, osmium::memory::Buffer& buffer) {
+                const bool use_pool = m_use_pool_threads_for_nodes && osmium::index::is_dense_map<TMap>::value;
+                bool okay = true;
+
+                m_ways.clear();
+                clear_lookups();
+
+                if (!use_pool && node_tasks_pending()) {
+                    finish_node_tasks_impl(storage_pos, osmium::index::is_dense_map<TMap>{});
+                }
+
+                for (auto& item : buffer) {
+                    if (item.type() == osmium::item_type::node) {
+                        // ways seen so far must not see later nodes
+                        if (!m_ways.empty()) {
+                            okay = resolve_ways(storage_pos) && okay;
+                        }
+                        const auto& node = static_cast<const osmium::Node&>(item);
+                        m_must_sort = true;
+                        const osmium::object_id_type id = node.id();
+                        if (id < 0) {
+                            m_storage_neg.set(static_cast<osmium::unsigned_object_id_type>(-id), node.location());
+                        } else if (use_pool) {
+                            m_node_batch.emplace_back(static_cast<osmium::unsigned_object_id_type>(id), node.location());
+                        } else {
+                            storage_pos.set(static_cast<osmium::unsigned_object_id_type>(id), node.location());
+                        }
+                    } else if (item.type() == osmium::item_type::way) {
+                        if (node_tasks_pending()) {
+                            finish_node_tasks_impl(storage_pos, osmium::index::is_dense_map<TMap>{});
+                        }
+                        auto& way = static_cast<osmium::Way&>(item);
+                        m_ways.push_back(&way);
+                        add_lookups(way);
+                        if (m_pos_ids.size() + m_neg_ids.size() >= lookup_batch_size) {
+                            okay = resolve_ways(storage_pos) && okay;
+                        }
+                    }
+                }
+
+                if (!m_ways.empty()) {
+                    okay = resolve_ways(storage_pos) && okay;
+                }
+
+                if (m_node_batch.size() >= node_batch_size) {
+                    submit_node_batch(storage_pos, osmium::index::is_dense_map<TMap>{});
+                }
+
+                check_error(okay);
+            }
+
+            void check_error(bool okay) const {
+                if (!okay && !m_ignore_errors) {
+                    throw osmium::not_found("location for one or more nodes not found in node location index");
+                }
+            }
+
+        public:
+
             NodeLocationsForWays(const NodeLocationsForWays&) = delete;
             NodeLocationsForWays& operator=(const NodeLocationsForWays&) = delete;
 
             NodeLocationsForWays(NodeLocationsForWays&&) = default;
             NodeLocationsForWays& operator=(NodeLocationsForWays&&) = default;
 
-            ~NodeLocationsForWays() noexcept = default;
+            ~NodeLocationsForWays() noexcept {
+                try {
+                    wait_for_node_tasks();
+                } catch (...) {
+                    // ignore exceptions, there is nothing we can do here
+                }
+            }
 
             void ignore_errors() {
                 m_ignore_errors = true;
             }
 
+            /**
+             * Use the concurrent set mode of dense indexes in
+             * process_buffer(): The node locations are stored in the
+             * index for positive IDs by tasks on the thread pool, while
+             * the caller can go on reading the next buffer. This only has
+             * an effect if the index for positive IDs is a dense map
+             * (derived from VectorBasedDenseMap), otherwise the node
+             * locations are stored as usual.
+             *
+             * The tasks are waited for before locations are looked up for
+             * the first way after some nodes and in node(), way() and
+             * clear(). Call flush() before accessing the index in any
+             * other way.
+             */
+            void use_pool_threads_for_nodes() {
+                m_use_pool_threads_for_nodes = true;
+            }
+
+            /**
+             * Wait until the locations of all nodes handed to
+             * process_buffer() are stored in the index.
+             */
+            void flush() {
+                finish_node_tasks();
+            }
+
             /**
              * Store the location of the node in the storage.
              */
             void node(const osmium::Node& node) {
+                finish_node_tasks();
                 m_must_sort = true;
                 const osmium::object_id_type id = node.id();
                 if (id >= 0) {
@@ -125,7 +478,8 @@ namespace osmium {
             }
 
             /**
-             * Get location of node with given id.
+             * Get location of node with given id. If
+             * use_pool_threads_for_nodes() was called, call flush() first.
              */
             osmium::Location get_node_location(const osmium::object_id_type id) const {
                 if (id >= 0) {
@@ -140,25 +494,32 @@ namespace osmium {
              * them to the way object.
              */
             void way(osmium::Way& way) {
-                if (m_must_sort) {
-                    m_storage_pos.sort();
-                    m_storage_neg.sort();
-                    m_must_sort = false;
-                }
-                bool error = false;
-                for (auto& node_ref : way.nodes()) {
-                    try {
-                        node_ref.set_location(get_node_location(node_ref.ref()));
-                        if (!node_ref.location()) {
-                            error = true;
-                        }
-                    } catch (osmium::not_found&) {
-                        error = true;
-                    }
-                }
-                if (error && !m_ignore_errors) {
-                    throw osmium::not_found("location for one or more nodes not found in node location index");
-                }
+                finish_node_tasks();
+                clear_lookups();
+                add_lookups(way);
+                run_lookups(m_storage_pos);
+                size_t pos_index = 0;
+                size_t neg_index = 0;
+                check_error(set_locations(way, pos_index, neg_index));
+            }
+
+            /**
+             * Handle all nodes and ways in the buffer. This has the same
+             * effect as calling osmium::apply(buffer, handler), but the
+             * node locations needed for consecutive ways are looked up in
+             * batches, which is much faster for large indexes.
+             *
+             * If there are errors, the exception is thrown only after all
+             * ways in the buffer have been handled.
+             *
+             * If the handler was instantiated with the abstract
+             * osmium::index::map::Map class as index type for positive
+             * IDs, the concrete type of the index is determined once for
+             * the buffer, so that storing and retrieving locations doesn't
+             * need virtual calls.
+             */
+            void process_buffer(osmium::memory::Buffer& buffer) {
+                osmium::index::call_with_concrete_map(m_storage_pos, buffer_processor{*this, buffer});
             }
 
             /**
@@ -167,6 +528,7 @@ namespace osmium {
              * memory if thats needed.
              */
             void clear() {
+                finish_node_tasks();
                 m_storage_pos.clear();
                 m_storage_neg.clear();
             }
@@ -0,0 +1,273 @@
+#ifndef OSMIUM_HANDLER_NODE_LOCATIONS_UPDATER_HPP
+#define OSMIUM_HANDLER_NODE_LOCATIONS_UPDATER_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <osmium/handler.hpp>
+#include <osmium/index/detail/vector_map.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/multimap/sparse_mem_array.hpp>
+#include <osmium/osm/diff_object.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * Handler to update an existing node location index, usually a
+         * file-backed one (DenseFileArray or SparseFileArray), with the
+         * nodes from a change file. Use it with osmium::apply() on a
+         * change file or with osmium::apply_diff() on a history file,
+         * in which case only the last version of each node is used.
+         *
+         * New and changed node locations are set in the index, deleted
+         * nodes are set to the empty location. Dense indexes grow if
+         * needed. Sorted sparse indexes are updated in place where
+         * possible, new ids are appended and the index is sorted again
+         * in flush(). Only nodes with positive ids are handled.
+         *
+         * Optionally a node-to-way index (as created by the
+         * ObjectRelations handler) can be given. It is used to find the
+         * ways that are affected by moved or deleted nodes and it is
+         * updated with the node references of the ways in the change
+         * file. Old references can't be removed, because the old node
+         * lists of changed ways are not known, so there can be some ways
+         * returned by affected_ways() which don't actually need updating.
+         *
+         * Call flush() or affected_ways() after all changes are applied.
+         *
+         * @tparam TIndex Location index type.
+         * @tparam TNodeWayIndex Node-to-way multimap type, needs get_all().
+         */
+        template <typename TIndex,
+                  typename TNodeWayIndex = osmium::index::multimap::SparseMemArray<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>>
+        class NodeLocationsUpdater : public osmium::handler::Handler {
+
+            TIndex& m_index;
+            TNodeWayIndex* m_node_way_index;
+
+            // Ids of nodes which had a location before and got a new one
+            // or were deleted.
+            std::vector<osmium::unsigned_object_id_type> m_moved_nodes;
+
+            // Nodes which have to be added to a sparse index in flush().
+            std::vector<std::pair<osmium::unsigned_object_id_type, osmium::Location>> m_new_nodes;
+
+            bool m_must_sort_node_way_index {false};
+
+            osmium::Location old_location(const osmium::unsigned_object_id_type id) const {
+                osmium::Location location;
+                m_index.get_many(&id, &location, 1);
+                return location;
+            }
+
+            template <typename TMap>
+            void store(TMap& index, const osmium::unsigned_object_id_type id, const osmium::Location location) {
+                index.set(id, location);
+            }
+
+            template <typename TId, typename TValue, template<typename...> class TVector>
+            void store(osmium::index::map::VectorBasedSparseMap<TId, TValue, TVector>& index, const osmium::unsigned_object_id_type id, const osmium::Location location) {
+                if (!index.update(id, location)) {
+                    m_new_nodes.emplace_back(id, location);
+                }
+            }
+
+            template <typename TMap>
+            void store_delete_of_missing_node(TMap& /*index*/, const osmium::unsigned_object_id_type /*id*/) {
+            }
+
+            // A node not in the sparse index can still have a pending
+            // entry in m_new_nodes if it was created earlier in the same
+            // change. Record the delete, so that the last version wins in
+            // add_new_nodes().
+            template <typename TId, typename TValue, template<typename...> class TVector>
+            void store_delete_of_missing_node(osmium::index::map::VectorBasedSparseMap<TId, TValue, TVector>& /*index*/, const osmium::unsigned_object_id_type id) {
+                if (!m_new_nodes.empty()) {
+                    m_new_nodes.emplace_back(id, osmium::Location{});
+                }
+            }
+
+            template <typename TMap>
+            void add_new_nodes(TMap& /*index*/) {
+            }
+
+            template <typename TId, typename TValue, template<typename...> class TVector>
+            void add_new_nodes(osmium::index::map::VectorBasedSparseMap<TId, TValue, TVector>& index) {
+                if (m_new_nodes.empty()) {
+                    return;
+                }
+
+                // If a node is in the change file several times, the last
+                // version wins.
+                std::stable_sort(m_new_nodes.begin(), m_new_nodes.end(), [](const std::pair<osmium::unsigned_object_id_type, osmium::Location>& a,
+                                                                            const std::pair<osmium::unsigned_object_id_type, osmium::Location>& b) {
+                    return a.first < b.first;
+                });
+                for (auto it = m_new_nodes.begin(); it != m_new_nodes.end(); ++it) {
+                    if (std::next(it) == m_new_nodes.end() || std::next(it)->first != it->first) {
+                        if (it->second) {
+                            index.set(it->first, it->second);
+                        }
+                    }
+                }
+                m_new_nodes.clear();
+
+                index.sort();
+            }
+
+        public:
+
+            explicit NodeLocationsUpdater(TIndex& index) :
+                m_index(index),
+                m_node_way_index(nullptr) {
+            }
+
+            NodeLocationsUpdater(TIndex& index, TNodeWayIndex& node_way_index) :
+                m_index(index),
+                m_node_way_index(&node_way_index) {
+            }
+
+            void node(const osmium::Node& node) {
+                if (node.id() <= 0) {
+                    return;
+                }
+                const osmium::unsigned_object_id_type id = node.positive_id();
+                const osmium::Location location = node.visible() ? node.location() : osmium::Location{};
+
+                const osmium::Location old = old_location(id);
+                if (old == location) {
+                    if (!location) {
+                        store_delete_of_missing_node(m_index, id);
+                    }
+                    return;
+                }
+                if (old) {
+                    m_moved_nodes.push_back(id);
+                }
+                store(m_index, id, location);
+            }
+
+            void way(const osmium::Way& way) {
+                if (m_node_way_index && way.visible()) {
+                    for (const auto& node_ref : way.nodes()) {
+                        m_node_way_index->set(node_ref.positive_ref(), way.positive_id());
+                    }
+                    m_must_sort_node_way_index = true;
+                }
+            }
+
+            /// Handle the last version of each node in a history file.
+            void node(const osmium::DiffNode& diff) {
+                if (diff.last()) {
+                    node(diff.curr());
+                }
+            }
+
+            /// Handle the last version of each way in a history file.
+            void way(const osmium::DiffWay& diff) {
+                if (diff.last()) {
+                    way(diff.curr());
+                }
+            }
+
+            void relation(const osmium::DiffRelation&) const {
+            }
+
+            using osmium::handler::Handler::relation;
+
+            /**
+             * Finish the update: Add new nodes to sparse indexes and sort
+             * them and the node-to-way index.
+             */
+            void flush() {
+                add_new_nodes(m_index);
+                if (m_must_sort_node_way_index) {
+                    m_node_way_index->sort();
+                    m_must_sort_node_way_index = false;
+                }
+            }
+
+            /**
+             * Ids of all nodes that had a location before this update and
+             * were moved or deleted. Sorted, without duplicates.
+             */
+            std::vector<osmium::unsigned_object_id_type> moved_nodes() {
+                std::sort(m_moved_nodes.begin(), m_moved_nodes.end());
+                m_moved_nodes.erase(std::unique(m_moved_nodes.begin(), m_moved_nodes.end()), m_moved_nodes.end());
+                return m_moved_nodes;
+            }
+
+            /**
+             * Ids of all ways referencing a node that was moved or deleted
+             * according to the node-to-way index. Sorted, without
+             * duplicates. Calls flush().
+             *
+             * Returns an empty vector if there is no node-to-way index.
+             */
+            std::vector<osmium::unsigned_object_id_type> affected_ways() {
+                flush();
+
+                std::vector<osmium::unsigned_object_id_type> ways;
+                if (!m_node_way_index) {
+                    return ways;
+                }
+
+                for (const auto id : moved_nodes()) {
+                    const auto range = m_node_way_index->get_all(id);
+                    for (auto it = range.first; it != range.second; ++it) {
+                        ways.push_back(it->second);
+                    }
+                }
+
+                std::sort(ways.begin(), ways.end());
+                ways.erase(std::unique(ways.begin(), ways.end()), ways.end());
+                return ways;
+            }
+
+        }; // class NodeLocationsUpdater
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_NODE_LOCATIONS_UPDATER_HPP
@@ -125,7 +125,7 @@ namespace osmium {
 
             void push_back(const T& value) {
                 if (m_size >= capacity()) {
-                    resize(m_size+1);
+                    reserve(m_size + osmium::detail::mmap_vector_size_increment);
                 }
                 data()[m_size] = value;
                 ++m_size;
@@ -0,0 +1,281 @@
+#ifndef OSMIUM_INDEX_DETAIL_PARALLEL_SORT_HPP
+#define OSMIUM_INDEX_DETAIL_PARALLEL_SORT_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            // Below this number of elements sorting is done single-threaded
+            // with std::sort.
+            constexpr size_t min_parallel_sort_size = 1024 * 1024;
+
+            // Number of bits of the key handled in each radix sort pass.
+            constexpr unsigned radix_bits = 8;
+
+            constexpr size_t radix_buckets = size_t(1) << radix_bits;
+
+            /**
+             * Run func(chunk, begin, end) for num_chunks consecutive parts
+             * of the range [0, size) on the thread pool and wait for all of
+             * them to finish. The first exception thrown by func is
+             * re-thrown after all parts are done.
+             *
+             * If called from a task running on the pool, the parts are run
+             * one after the other in the calling thread, because waiting
+             * for other tasks there can deadlock.
+             */
+            template <typename TFunc>
+            void run_on_chunks(osmium::thread::Pool& pool, size_t num_chunks, size_t size, TFunc&& func) {
+                const bool run_here = pool.is_worker_thread();
+                std::exception_ptr exception;
+                std::vector<std::future<void>> futures;
+                futures.reserve(run_here ? 0 : num_chunks);
+                for (size_t i = 0; i < num_chunks; ++i) {
+                    const size_t begin = size * i / num_chunks;
+                    const size_t end = size * (i + 1) / num_chunks;
+                    if (run_here) {
+                        try {
+                            func(i, begin, end);
+                        } catch (...) {
+                            if (!exception) {
+                                exception = std::current_exception();
+                            }
+                        }
+                    } else {
+                        futures.push_back(pool.submit([&func, i, begin, end] {
+                            func(i, begin, end);
+                        }));
+                    }
+                }
+                for (auto& future : futures) {
+                    try {
+                        future.get();
+                    } catch (...) {
+                        if (!exception) {
+                            exception = std::current_exception();
+                        }
+                    }
+                }
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+            template <typename T>
+            bool parallel_is_sorted(osmium::thread::Pool& pool, size_t num_chunks, const T* data, size_t size) {
+                std::vector<char> sorted(num_chunks, 0);
+                run_on_chunks(pool, num_chunks, size, [&](size_t chunk, size_t begin, size_t end) {
+                    // each chunk also checks the transition to the next chunk
+                    const size_t check_end = end < size ? end + 1 : end;
+                    sorted[chunk] = std::is_sorted(data + begin, data + check_end);
+                });
+                return std::all_of(sorted.begin(), sorted.end(), [](char s) {
+                    return s != 0;
+                });
+            }
+
+            /**
+             * Sort a range of std::pair-like elements by their "first"
+             * member (the key) using a parallel LSD radix sort on the
+             * thread pool. The radix sort is stable, so afterwards every run
+             * of elements with the same key is sorted by the "second"
+             * member (the value). The result is the same as with std::sort.
+             *
+             * Needs a temporary buffer of the same size as the data, which
+             * is allocated as an anonymous memory mapping. If that fails,
+             * std::sort is used instead.
+             *
+             * If called from a task running on the pool, the work is done
+             * in the calling thread.
+             */
+            template <typename T>
+            void parallel_radix_sort(osmium::thread::Pool& pool, size_t num_chunks, T* data, size_t size) {
+                typedef decltype(data->first) key_type;
+
+                std::vector<key_type> min_keys(num_chunks);
+                std::vector<key_type> max_keys(num_chunks);
+                run_on_chunks(pool, num_chunks, size, [&](size_t chunk, size_t begin, size_t end) {
+                    const auto minmax = std::minmax_element(data + begin, data + end, [](const T& a, const T& b) {
+                        return a.first < b.first;
+                    });
+                    min_keys[chunk] = minmax.first->first;
+                    max_keys[chunk] = minmax.second->first;
+                });
+                const uint64_t min_key = *std::min_element(min_keys.begin(), min_keys.end());
+                const uint64_t max_key = *std::max_element(max_keys.begin(), max_keys.end());
+
+                // number of low bits in which the keys can differ
+                unsigned key_bits = 0;
+                for (uint64_t diff = min_key ^ max_key; diff != 0; diff >>= 1) {
+                    ++key_bits;
+                }
+
+                std::unique_ptr<osmium::util::TypedMemoryMapping<T>> scratch;
+                try {
+                    scratch.reset(new osmium::util::TypedMemoryMapping<T>(size));
+                } catch (const std::system_error&) {
+                    std::sort(data, data + size);
+                    return;
+                }
+
+                T* src = data;
+                T* dest = scratch->begin();
+
+                typedef std::array<size_t, radix_buckets> histogram_type;
+                std::vector<histogram_type> histograms(num_chunks);
+
+                for (unsigned shift = 0; shift < key_bits; shift += radix_bits) {
+                    run_on_chunks(pool, num_chunks, size, [&](size_t chunk, size_t begin, size_t end) {
+                        histogram_type& histogram = histograms[chunk];
+                        histogram.fill(0);
+                        for (size_t i = begin; i < end; ++i) {
+                            ++histogram[(static_cast<uint64_t>(src[i].first) >> shift) & (radix_buckets - 1)];
+                        }
+                    });
+
+                    // Turn counts into start offsets in bucket-major,
+                    // chunk-minor order, this keeps the sort stable.
+                    // If one bucket gets all elements, all keys have the
+                    // same byte here and the pass can be skipped.
+                    size_t offset = 0;
+                    bool all_in_one_bucket = false;
+                    for (size_t bucket = 0; bucket < radix_buckets; ++bucket) {
+                        const size_t bucket_begin = offset;
+                        for (auto& histogram : histograms) {
+                            const size_t count = histogram[bucket];
+                            histogram[bucket] = offset;
+                            offset += count;
+                        }
+                        if (offset - bucket_begin == size) {
+                            all_in_one_bucket = true;
+                        }
+                    }
+
+                    if (all_in_one_bucket) {
+                        continue;
+                    }
+
+                    run_on_chunks(pool, num_chunks, size, [&](size_t chunk, size_t begin, size_t end) {
+                        histogram_type& offsets = histograms[chunk];
+                        for (size_t i = begin; i < end; ++i) {
+                            dest[offsets[(static_cast<uint64_t>(src[i].first) >> shift) & (radix_buckets - 1)]++] = src[i];
+                        }
+                    });
+
+                    std::swap(src, dest);
+                }
+
+                if (src != data) {
+                    run_on_chunks(pool, num_chunks, size, [&](size_t, size_t begin, size_t end) {
+                        std::copy(src + begin, src + end, data + begin);
+                    });
+                }
+
+                // Sort runs of elements with the same key by value. Chunk
+                // boundaries are moved so that no run is split.
+                run_on_chunks(pool, num_chunks, size, [&](size_t, size_t begin, size_t end) {
+                    while (begin > 0 && begin < size && data[begin - 1].first == data[begin].first) {
+                        ++begin;
+                    }
+                    while (end < size && data[end - 1].first == data[end].first) {
+                        ++end;
+                    }
+                    while (begin < end) {
+                        size_t run_end = begin + 1;
+                        while (run_end < end && data[run_end].first == data[begin].first) {
+                            ++run_end;
+                        }
+                        if (run_end - begin > 1) {
+                            std::sort(data + begin, data + run_end);
+                        }
+                        begin = run_end;
+                    }
+                });
+            }
+
+            /**
+             * Sort a vector of std::pair-like elements (such as the ones
+             * used in the sparse index maps and multimaps). This works for
+             * std::vector as well as for the mmap-based vectors.
+             *
+             * If the data is already sorted, which is the usual case when
+             * reading OSM files sorted by ID, nothing is done. Large vectors
+             * are sorted with a parallel radix sort on the thread pool.
+             *
+             * This can be called from a task running on the thread pool,
+             * the sort then runs in that task only.
+             */
+            template <typename TVector>
+            void sort_pairs(TVector& vector) {
+                const size_t size = vector.size();
+                auto* data = vector.data();
+
+                if (size < min_parallel_sort_size) {
+                    if (!std::is_sorted(data, data + size)) {
+                        std::sort(data, data + size);
+                    }
+                    return;
+                }
+
+                osmium::thread::Pool& pool = osmium::thread::Pool::instance();
+                const size_t num_chunks = static_cast<size_t>(pool.num_threads());
+
+                if (!parallel_is_sorted(pool, num_chunks, data, size)) {
+                    parallel_radix_sort(pool, num_chunks, data, size);
+                }
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_PARALLEL_SORT_HPP
@@ -0,0 +1,208 @@
+#ifndef OSMIUM_INDEX_DETAIL_SEARCH_INDEX_HPP
+#define OSMIUM_INDEX_DETAIL_SEARCH_INDEX_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Search index over a large sorted array of std::pair-like
+             * elements with the key in the "first" member.
+             *
+             * It stores the key of every block_size'th element in
+             * Eytzinger order (the layout of a binary heap). The top
+             * levels of this implicit tree are shared by all searches and
+             * stay in cache, and the whole index is small enough to
+             * mostly stay in cache, too. So a lookup only has to wait for
+             * the cache misses in the window of window_size elements of
+             * the actual data it narrows the search down to, instead of
+             * the log2(n) cache misses of a binary search over the whole
+             * array.
+             *
+             * The index needs 16 bytes for every block_size elements.
+             */
+            template <typename TId>
+            class SearchIndex {
+
+                // Keys in Eytzinger order, m_keys[0] is unused, the root
+                // is at m_keys[1].
+                std::vector<TId> m_keys;
+
+                // Block number for each entry in m_keys.
+                std::vector<size_t> m_blocks;
+
+                size_t m_size = 0;
+
+                // Number of complete levels of the tree.
+                size_t m_full_levels = 0;
+
+                template <typename T>
+                size_t build_subtree(const T* data, size_t n, size_t pos) {
+                    if (n < m_keys.size()) {
+                        pos = build_subtree(data, 2 * n, pos);
+                        m_keys[n] = data[pos * block_size].first;
+                        m_blocks[n] = pos;
+                        ++pos;
+                        pos = build_subtree(data, 2 * n + 1, pos);
+                    }
+                    return pos;
+                }
+
+                // Walking down the tree ended at node n (which is beyond
+                // the last level). Go back up to the last node where we
+                // went left. This is the node with the first key not
+                // smaller than the search key. The element we are looking
+                // for is in the block before this sample or is the sample
+                // itself. If there is no such node, it is in the last
+                // block.
+                size_t window_begin(size_t n) const noexcept {
+                    while (n & 1) {
+                        n >>= 1;
+                    }
+                    n >>= 1;
+                    const size_t num_blocks = m_keys.size() - 1;
+                    const size_t block = n == 0 ? num_blocks : m_blocks[n];
+                    const size_t begin = block == 0 ? 0 : (block - 1) * block_size;
+                    return std::min(begin, m_size - window_size);
+                }
+
+            public:
+
+                /// Number of elements per block.
+                static constexpr size_t block_size = 32;
+
+                /// Number of elements in the window returned by a search.
+                static constexpr size_t window_size = block_size + 1;
+
+                /// Indexes are only built for arrays with at least this many elements.
+                static constexpr size_t min_size = 1024 * 1024;
+
+                SearchIndex() = default;
+
+                bool empty() const noexcept {
+                    return m_keys.empty();
+                }
+
+                void clear() {
+                    m_keys.clear();
+                    m_keys.shrink_to_fit();
+                    m_blocks.clear();
+                    m_blocks.shrink_to_fit();
+                    m_size = 0;
+                    m_full_levels = 0;
+                }
+
+                size_t used_memory() const noexcept {
+                    return m_keys.capacity() * sizeof(TId) + m_blocks.capacity() * sizeof(size_t);
+                }
+
+                /**
+                 * Build the index for the sorted array data of the given
+                 * size. The size must be at least window_size.
+                 */
+                template <typename T>
+                void build(const T* data, size_t size) {
+                    assert(size >= window_size);
+                    clear();
+                    m_size = size;
+                    const size_t num_nodes = (size + block_size - 1) / block_size + 1;
+                    m_keys.resize(num_nodes);
+                    m_blocks.resize(num_nodes);
+                    build_subtree(data, 1, 0);
+                    while ((size_t(2) << m_full_levels) <= num_nodes) {
+                        ++m_full_levels;
+                    }
+                }
+
+                /**
+                 * Find the window of window_size elements in the indexed
+                 * array that contains the first element with a key not
+                 * smaller than the given one, if there is such an element.
+                 *
+                 * @returns Index of the first element of the window.
+                 */
+                size_t find(const TId key) const noexcept {
+                    const TId* const keys = m_keys.data();
+                    const size_t num_nodes = m_keys.size();
+                    size_t n = 1;
+                    while (n < num_nodes) {
+                        n = 2 * n + (keys[n] < key);
+                    }
+                    return window_begin(n);
+                }
+
+                /**
+                 * Same as find(), but for count keys at once. The searches
+                 * are run in lockstep, so that their cache misses overlap.
+                 * The window begins are written to result.
+                 */
+                void find_many(const TId* key, size_t* result, const size_t count) const noexcept {
+                    const TId* const keys = m_keys.data();
+                    const size_t num_nodes = m_keys.size();
+                    std::fill_n(result, count, 1);
+                    for (size_t level = 0; level < m_full_levels; ++level) {
+                        for (size_t j = 0; j < count; ++j) {
+                            const size_t n = result[j];
+                            result[j] = 2 * n + (keys[n] < key[j]);
+                        }
+                    }
+                    // the last level is usually not complete
+                    for (size_t j = 0; j < count; ++j) {
+                        const size_t n = result[j];
+                        if (n < num_nodes) {
+                            result[j] = 2 * n + (keys[n] < key[j]);
+                        }
+                    }
+                    for (size_t j = 0; j < count; ++j) {
+                        result[j] = window_begin(result[j]);
+                    }
+                }
+
+            }; // class SearchIndex
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_SEARCH_INDEX_HPP
@@ -34,18 +34,109 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <algorithm>
+#include <cassert>
 #include <cstddef>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 
+#include <osmium/index/detail/parallel_sort.hpp>
+#include <osmium/index/detail/search_index.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/compatibility.hpp>
 
 namespace osmium {
 
     namespace index {
 
+        namespace detail {
+
+            // How many elements ahead get_many() prefetches in dense maps.
+            constexpr size_t prefetch_distance = 8;
+
+            // How many lookups get_many() interleaves in sparse maps.
+            constexpr size_t interleaved_lookups = 16;
+
+            /**
+             * Look up the values for n ids in a dense array. The memory for
+             * ids further down the list is prefetched while earlier ids are
+             * looked up.
+             */
+            template <typename TId, typename TValue>
+            inline void dense_get_many(const TValue* data, const size_t size, const TId* ids, TValue* values, const size_t n) {
+                for (size_t i = 0; i < n; ++i) {
+                    if (i + prefetch_distance < n) {
+                        const TId ahead = ids[i + prefetch_distance];
+                        if (ahead < size) {
+                            OSMIUM_PREFETCH(data + ahead);
+                        }
+                    }
+                    values[i] = ids[i] < size ? data[ids[i]] : osmium::index::empty_value<TValue>();
+                }
+            }
+
+            /**
+             * Look up the values for n ids in a sorted array of (id, value)
+             * pairs. Up to interleaved_lookups binary searches are run in
+             * lockstep, and the next probe of each search is prefetched, so
+             * the cache misses of the searches overlap. If search_index is
+             * not nullptr, it is used the same way to narrow down the range
+             * of each binary search first.
+             */
+            template <typename TId, typename TValue>
+            inline void sparse_get_many(const std::pair<TId, TValue>* first, const size_t size, const SearchIndex<TId>* search_index, const TId* ids, TValue* values, const size_t n) {
+                typedef std::pair<TId, TValue> element_type;
+
+                if (size == 0) {
+                    std::fill_n(values, n, osmium::index::empty_value<TValue>());
+                    return;
+                }
+
+                const element_type* base[interleaved_lookups];
+                size_t window[interleaved_lookups];
+
+                for (size_t start = 0; start < n; start += interleaved_lookups) {
+                    const size_t count = std::min(n - start, interleaved_lookups);
+                    const TId* batch_ids = ids + start;
+
+                    size_t len = size;
+                    if (!search_index) {
+                        std::fill_n(base, count, first);
+                    } else {
+                        search_index->find_many(batch_ids, window, count);
+                        len = SearchIndex<TId>::window_size;
+                        for (size_t j = 0; j < count; ++j) {
+                            base[j] = first + window[j];
+                            OSMIUM_PREFETCH(base[j] + len / 2);
+                        }
+                    }
+
+                    while (len > 1) {
+                        const size_t half = len / 2;
+                        len -= half;
+                        for (size_t j = 0; j < count; ++j) {
+                            if (base[j][half].first < batch_ids[j]) {
+                                base[j] += half;
+                            }
+                            OSMIUM_PREFETCH(base[j] + len / 2);
+                        }
+                    }
+
+                    for (size_t j = 0; j < count; ++j) {
+                        const element_type* result = base[j] + (base[j]->first < batch_ids[j]);
+                        if (result != first + size && result->first == batch_ids[j]) {
+                            values[start + j] = result->second;
+                        } else {
+                            values[start + j] = osmium::index::empty_value<TValue>();
+                        }
+                    }
+                }
+            }
+
+        } // namespace detail
+
         namespace map {
 
             template <typename TVector, typename TId, typename TValue>
@@ -81,6 +172,29 @@ namespace osmium {
                     m_vector[id] = value;
                 }
 
+                /**
+                 * Change the size of the map, so that it can hold all ids
+                 * smaller than new_size. New entries are empty.
+                 */
+                void resize(const size_t new_size) {
+                    m_vector.resize(new_size);
+                }
+
+                /**
+                 * Set the value for the id in concurrent set mode. Unlike
+                 * set() this never grows the map, so the id must be
+                 * smaller than size(). Use resize() first if needed.
+                 *
+                 * Because every id has its own slot in a dense map, this
+                 * can be called from several threads at the same time, as
+                 * long as they set different ids and no other non-const
+                 * member function is called while they are running.
+                 */
+                void set_concurrently(const TId id, const TValue value) noexcept {
+                    assert(id < size());
+                    m_vector.data()[id] = value;
+                }
+
                 const TValue get(const TId id) const final {
                     try {
                         const TValue& value = m_vector.at(id);
@@ -93,6 +207,15 @@ namespace osmium {
                     }
                 }
 
+                /**
+                 * Retrieve values for several ids at once. The memory for
+                 * ids further down the list is prefetched while earlier
+                 * ids are looked up.
+                 */
+                void get_many(const TId* ids, TValue* values, const size_t n) const final {
+                    detail::dense_get_many(m_vector.data(), m_vector.size(), ids, values, n);
+                }
+
                 size_t size() const final {
                     return m_vector.size();
                 }
@@ -155,6 +278,32 @@ namespace osmium {
 
                 vector_type m_vector;
 
+                // Only built by sort() for large vectors.
+                detail::SearchIndex<TId> m_search_index;
+
+                // Returns the position of the first element with the given
+                // id or the end position if there is none.
+                size_t find(const TId id) const {
+                    const element_type* const first = m_vector.data();
+                    const element_type* begin = first;
+                    const element_type* end = first + m_vector.size();
+                    if (!m_search_index.empty()) {
+                        begin = first + m_search_index.find(id);
+                        end = begin + detail::SearchIndex<TId>::window_size;
+                    }
+                    const element_type element {
+                        id,
+                        osmium::index::empty_value<TValue>()
+                    };
+                    const element_type* result = std::lower_bound(begin, end, element, [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+                    if (result == end || result->first != id) {
+                        return m_vector.size();
+                    }
+                    return static_cast<size_t>(result - first);
+                }
+
             public:
 
                 VectorBasedSparseMap() :
@@ -168,22 +317,45 @@ namespace osmium {
                 ~VectorBasedSparseMap() final = default;
 
                 void set(const TId id, const TValue value) final {
+                    if (!m_search_index.empty()) {
+                        m_search_index.clear();
+                    }
                     m_vector.push_back(element_type(id, value));
                 }
 
+                /**
+                 * Change the value for an id that is already in the map
+                 * in place. The map must be sorted.
+                 *
+                 * @returns false if the id is not in the map.
+                 */
+                bool update(const TId id, const TValue value) {
+                    const size_t pos = find(id);
+                    if (pos == m_vector.size()) {
+                        return false;
+                    }
+                    m_vector[pos].second = value;
+                    return true;
+                }
+
                 const TValue get(const TId id) const final {
-                    const element_type element {
-                        id,
-                        osmium::index::empty_value<TValue>()
-                    };
-                    const auto result = std::lower_bound(m_vector.begin(), m_vector.end(), element, [](const element_type& a, const element_type& b) {
-                        return a.first < b.first;
-                    });
-                    if (result == m_vector.end() || result->first != id) {
+                    const size_t pos = find(id);
+                    if (pos == m_vector.size()) {
                         not_found_error(id);
-                    } else {
-                        return result->second;
                     }
+                    return m_vector.data()[pos].second;
+                }
+
+                /**
+                 * Retrieve values for several ids at once. Up to
+                 * detail::interleaved_lookups binary searches are run in
+                 * lockstep, and the next probe of each search is prefetched,
+                 * so the cache misses of the searches overlap. If there is
+                 * a search index, it is used the same way to narrow down
+                 * the range of each binary search first.
+                 */
+                void get_many(const TId* ids, TValue* values, const size_t n) const final {
+                    detail::sparse_get_many(m_vector.data(), m_vector.size(), m_search_index.empty() ? nullptr : &m_search_index, ids, values, n);
                 }
 
                 size_t size() const final {
@@ -195,16 +367,32 @@ namespace osmium {
                 }
 
                 size_t used_memory() const final {
-                    return sizeof(element_type) * size();
+                    return sizeof(element_type) * size() + m_search_index.used_memory();
                 }
 
                 void clear() final {
                     m_vector.clear();
                     m_vector.shrink_to_fit();
-                }
-
+                    m_search_index.clear();
+                }
+
+                /**
+                 * Sort the data. Nothing is done if it is already sorted,
+                 * large amounts of data are sorted in parallel on the
+                 * thread pool.
+                 *
+                 * For large maps this also builds a small search index
+                 * (see detail::SearchIndex) which makes lookups much more
+                 * cache-friendly. It is discarded when set() is called.
+                 */
                 void sort() final {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    if (!m_search_index.empty()) {
+                        return;
+                    }
+                    osmium::index::detail::sort_pairs(m_vector);
+                    if (m_vector.size() >= detail::SearchIndex<TId>::min_size) {
+                        m_search_index.build(m_vector.data(), m_vector.size());
+                    }
                 }
 
                 void dump_as_list(const int fd) final {
@@ -239,6 +427,23 @@ namespace osmium {
 
         } // namespace map
 
+        namespace detail {
+
+            template <typename TVector, typename TId, typename TValue>
+            std::true_type is_dense_map_helper(const map::VectorBasedDenseMap<TVector, TId, TValue>*);
+
+            std::false_type is_dense_map_helper(...);
+
+        } // namespace detail
+
+        /**
+         * Is TMap a dense map (derived from VectorBasedDenseMap) which
+         * supports the concurrent set mode?
+         */
+        template <typename TMap>
+        struct is_dense_map : decltype(detail::is_dense_map_helper(static_cast<TMap*>(nullptr))) {
+        };
+
     } // namespace index
 
 } // namespace osmium
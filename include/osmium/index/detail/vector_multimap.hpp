@@ -37,6 +37,7 @@ DEALINGS IN THE SOFTWARE.
 #include <cstddef>
 #include <utility>
 
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/multimap.hpp>
 #include <osmium/io/detail/read_write.hpp>
@@ -122,8 +123,13 @@ namespace osmium {
                     m_vector.shrink_to_fit();
                 }
 
+                /**
+                 * Sort the data. Nothing is done if it is already sorted,
+                 * large amounts of data are sorted in parallel on the
+                 * thread pool.
+                 */
                 void sort() final {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    osmium::index::detail::sort_pairs(m_vector);
                 }
 
                 void remove(const TId id, const TValue value) {
@@ -137,7 +143,7 @@ namespace osmium {
                 }
 
                 void consolidate() {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    osmium::index::detail::sort_pairs(m_vector);
                 }
 
                 void erase_removed() {
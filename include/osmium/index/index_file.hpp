@@ -0,0 +1,321 @@
+#ifndef OSMIUM_INDEX_INDEX_FILE_HPP
+#define OSMIUM_INDEX_INDEX_FILE_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <osmium/index/detail/vector_map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when an index file is not valid or doesn't fit
+     * the index it is loaded into.
+     */
+    struct index_file_error : public std::runtime_error {
+
+        index_file_error(const std::string& what) :
+            std::runtime_error(what) {
+        }
+
+        index_file_error(const char* what) :
+            std::runtime_error(what) {
+        }
+
+    }; // struct index_file_error
+
+    namespace index {
+
+        /**
+         * Layout of the data in an index file.
+         */
+        enum class index_file_type : uint32_t {
+            dense  = 1, ///< array of values indexed by id
+            sparse = 2  ///< list of (id, value) pairs sorted by id
+        };
+
+        /**
+         * Information about the OSM data an index file was created from.
+         * Use index_file_source_from_header() to get it from the header
+         * of the input file.
+         */
+        struct index_file_source {
+
+            /// Timestamp of the data, invalid if unknown.
+            osmium::Timestamp timestamp {};
+
+            /// Replication sequence number of the data, 0 if unknown.
+            uint64_t sequence_number = 0;
+
+        }; // struct index_file_source
+
+        /**
+         * Get the source information for an index file from the
+         * replication timestamp and sequence number in the header of
+         * an OSM file. They are set in PBF files created by Osmosis and
+         * Osmium from replication data.
+         */
+        inline index_file_source index_file_source_from_header(const osmium::io::Header& header) {
+            index_file_source source;
+
+            const std::string timestamp = header.get("osmosis_replication_timestamp");
+            if (!timestamp.empty()) {
+                try {
+                    source.timestamp = osmium::Timestamp(timestamp);
+                } catch (std::invalid_argument&) {
+                    // ignore invalid timestamps
+                }
+            }
+
+            const std::string sequence_number = header.get("osmosis_replication_sequence_number");
+            if (!sequence_number.empty()) {
+                source.sequence_number = std::strtoull(sequence_number.c_str(), nullptr, 10);
+            }
+
+            return source;
+        }
+
+        /**
+         * Header at the start of an index file. It is followed by the
+         * data of the index, either an array of values (for dense
+         * indexes) or a sorted list of std::pair<id, value> (for sparse
+         * indexes), in the same format dump_as_array() and
+         * dump_as_list() write.
+         *
+         * All numbers are stored in native byte order, so index files
+         * can't be used on machines with a different byte order. This
+         * is detected when reading the file.
+         */
+        struct index_file_header {
+
+            static constexpr const char* magic_string = "OSMIUMIX";
+            static constexpr uint32_t current_version = 1;
+
+            /// Flag: The data is sorted by id.
+            static constexpr uint32_t flag_sorted = 0x1;
+
+            char magic[8];
+
+            /// Version of the file format.
+            uint32_t version;
+
+            /// Layout of the data (index_file_type).
+            uint32_t type;
+
+            /// Size of the id type in bytes.
+            uint32_t id_size;
+
+            /// Size of the value type in bytes.
+            uint32_t value_size;
+
+            /// Size of one element of the data in bytes.
+            uint32_t element_size;
+
+            /// Flags, see flag_* constants.
+            uint32_t flags;
+
+            /// Number of elements in the data.
+            uint64_t num_elements;
+
+            /// Smallest and largest id in the data.
+            uint64_t min_id;
+            uint64_t max_id;
+
+            /// Timestamp (seconds since the epoch) of the source data, 0 if unknown.
+            uint64_t source_timestamp;
+
+            /// Replication sequence number of the source data, 0 if unknown.
+            uint64_t source_sequence_number;
+
+            char reserved[56];
+
+            index_file_type data_type() const noexcept {
+                return static_cast<index_file_type>(type);
+            }
+
+            bool sorted() const noexcept {
+                return (flags & flag_sorted) != 0;
+            }
+
+            index_file_source source() const noexcept {
+                index_file_source s;
+                s.timestamp = osmium::Timestamp(source_timestamp);
+                s.sequence_number = source_sequence_number;
+                return s;
+            }
+
+            /// Size of the data following the header in bytes. Only valid
+            /// for headers accepted by check_index_file_header().
+            uint64_t data_size() const noexcept {
+                return num_elements * element_size;
+            }
+
+        }; // struct index_file_header
+
+        static_assert(sizeof(index_file_header) == 128, "index_file_header has wrong size");
+
+        namespace detail {
+
+            template <typename TId, typename TValue>
+            inline index_file_header make_index_file_header(const index_file_type type, const size_t element_size, const size_t num_elements, const index_file_source& source) {
+                index_file_header header;
+                std::memset(&header, 0, sizeof(header));
+                std::memcpy(header.magic, index_file_header::magic_string, sizeof(header.magic));
+                header.version = index_file_header::current_version;
+                header.type = static_cast<uint32_t>(type);
+                header.id_size = sizeof(TId);
+                header.value_size = sizeof(TValue);
+                header.element_size = static_cast<uint32_t>(element_size);
+                header.flags = index_file_header::flag_sorted;
+                header.num_elements = num_elements;
+                header.source_timestamp = static_cast<uint64_t>(source.timestamp.seconds_since_epoch());
+                header.source_sequence_number = source.sequence_number;
+                return header;
+            }
+
+            inline void write_index_file_header(const int fd, const index_file_header& header) {
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+            }
+
+        } // namespace detail
+
+        /**
+         * Check the header of an index file and throw an
+         * osmium::index_file_error if it isn't valid or doesn't fit the
+         * given id and value types. Also checks that the file with the
+         * given size contains all the data.
+         */
+        template <typename TId, typename TValue>
+        inline void check_index_file_header(const index_file_header& header, const size_t file_size) {
+            if (std::memcmp(header.magic, index_file_header::magic_string, sizeof(header.magic))) {
+                throw osmium::index_file_error("not an index file");
+            }
+            if (header.version != index_file_header::current_version) {
+                throw osmium::index_file_error("unsupported index file version or byte order");
+            }
+            if (header.id_size != sizeof(TId) || header.value_size != sizeof(TValue)) {
+                throw osmium::index_file_error("index file has wrong id or value size");
+            }
+            switch (header.data_type()) {
+                case index_file_type::dense:
+                    if (header.element_size != sizeof(TValue)) {
+                        throw osmium::index_file_error("index file has wrong element size");
+                    }
+                    break;
+                case index_file_type::sparse:
+                    if (header.element_size != sizeof(std::pair<TId, TValue>)) {
+                        throw osmium::index_file_error("index file has wrong element size");
+                    }
+                    if (!header.sorted()) {
+                        throw osmium::index_file_error("sparse index file is not sorted");
+                    }
+                    break;
+                default:
+                    throw osmium::index_file_error("unknown index file type");
+            }
+            // Don't multiply num_elements by element_size here, a broken
+            // header can make that overflow.
+            if (file_size < sizeof(index_file_header) ||
+                header.num_elements > (file_size - sizeof(index_file_header)) / header.element_size) {
+                throw osmium::index_file_error("index file is truncated");
+            }
+        }
+
+        /**
+         * Read the header of the index file open on fd.
+         *
+         * @throws osmium::index_file_error if the file is too small.
+         */
+        inline index_file_header read_index_file_header(const int fd) {
+            if (osmium::util::file_size(fd) < sizeof(index_file_header)) {
+                throw osmium::index_file_error("not an index file");
+            }
+            osmium::util::MemoryMapping mapping(sizeof(index_file_header), osmium::util::MemoryMapping::mapping_mode::readonly, fd);
+            index_file_header header;
+            std::memcpy(&header, mapping.get_addr<char>(), sizeof(header));
+            return header;
+        }
+
+        /**
+         * Write the contents of a dense map to the file open on fd as an
+         * index file. Use osmium::index::map::IndexFileMap to read it.
+         */
+        template <typename TVector, typename TId, typename TValue>
+        inline void write_index_file(const int fd, const map::VectorBasedDenseMap<TVector, TId, TValue>& map, const index_file_source& source = index_file_source{}) {
+            auto header = detail::make_index_file_header<TId, TValue>(index_file_type::dense, sizeof(TValue), map.size(), source);
+            if (map.size() > 0) {
+                header.max_id = map.size() - 1;
+            }
+            detail::write_index_file_header(fd, header);
+            if (map.size() > 0) {
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&*map.cbegin()), map.byte_size());
+            }
+        }
+
+        /**
+         * Write the contents of a sparse map to the file open on fd as an
+         * index file. The map is sorted first. Use
+         * osmium::index::map::IndexFileMap to read it.
+         */
+        template <typename TId, typename TValue, template<typename...> class TVector>
+        inline void write_index_file(const int fd, map::VectorBasedSparseMap<TId, TValue, TVector>& map, const index_file_source& source = index_file_source{}) {
+            map.sort();
+            typedef typename map::VectorBasedSparseMap<TId, TValue, TVector>::element_type element_type;
+            auto header = detail::make_index_file_header<TId, TValue>(index_file_type::sparse, sizeof(element_type), map.size(), source);
+            if (map.size() > 0) {
+                header.min_id = map.cbegin()->first;
+                header.max_id = (map.cend() - 1)->first;
+            }
+            detail::write_index_file_header(fd, header);
+            if (map.size() > 0) {
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(&*map.cbegin()), map.byte_size());
+            }
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_INDEX_FILE_HPP
@@ -43,6 +43,7 @@ DEALINGS IN THE SOFTWARE.
 #include <type_traits>
 #include <vector>
 
+#include <osmium/index/index.hpp>
 #include <osmium/util/compatibility.hpp>
 #include <osmium/util/string.hpp>
 
@@ -117,6 +118,31 @@ namespace osmium {
                 /// Retrieve value by id. Does not check for overflow or empty fields.
                 virtual const TValue get(const TId id) const = 0;
 
+                /**
+                 * Retrieve values for several ids at once. This is usually
+                 * faster than calling get() for each id, because
+                 * implementations can prefetch data or look up the ids in
+                 * a more cache-friendly order.
+                 *
+                 * Unlike get() this does not throw an exception if an id
+                 * is not found. Instead the empty value (see
+                 * osmium::index::empty_value()) is stored for it.
+                 *
+                 * @param ids Pointer to array of n ids.
+                 * @param values Pointer to array of size n where the values
+                 *               will be written to.
+                 * @param n Number of ids.
+                 */
+                virtual void get_many(const TId* ids, TValue* values, const size_t n) const {
+                    for (size_t i = 0; i < n; ++i) {
+                        try {
+                            values[i] = get(ids[i]);
+                        } catch (osmium::not_found&) {
+                            values[i] = osmium::index::empty_value<TValue>();
+                        }
+                    }
+                }
+
                 /**
                  * Get the approximate number of items in the storage. The storage
                  * might allocate memory in blocks, so this size might not be
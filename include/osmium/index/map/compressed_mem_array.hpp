@@ -0,0 +1,418 @@
+#ifndef OSMIUM_INDEX_MAP_COMPRESSED_MEM_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_COMPRESSED_MEM_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <protozero/varint.hpp>
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+
+#define OSMIUM_HAS_INDEX_MAP_COMPRESSED_MEM_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * This index stores locations in a compressed form in memory.
+             *
+             * The ID space is divided into blocks of 1024 consecutive IDs.
+             * Each block is divided into 16 chunks of 64 IDs. Inside a chunk
+             * all locations are stored sorted by ID as varints: the gap to
+             * the previous ID followed by the zigzag-encoded deltas of the
+             * x and y coordinates to the previous location. Each block starts
+             * with a small offset table to the beginning of its chunks, so
+             * a lookup only has to decode one chunk. Recently decoded chunks
+             * are kept in a small cache.
+             *
+             * Blocks that do not contain any locations take up only the
+             * 8 bytes of their entry in the block offset table. Typically
+             * locations need 4 to 7 bytes each compared to the 8 bytes per
+             * possible ID of a dense index or the 16 bytes per location of
+             * a sparse index.
+             *
+             * Locations are collected in an uncompressed block buffer until
+             * a location from a different block is set. So this works best
+             * if locations are set ordered by ID, which is the case for
+             * most OSM files. Setting locations in random order works, but
+             * is slow and wastes memory, because the compressed blocks have
+             * to be re-written.
+             *
+             * Call sort() after you have set all locations and before
+             * reading them. It doesn't actually sort anything, but flushes
+             * the last block buffer.
+             *
+             * Note that, because of the chunk cache, get() is not thread-safe
+             * even though it is a const function.
+             *
+             * This will only work on 64 bit machines.
+             */
+            template <typename TId, typename TValue>
+            class CompressedMemArray : public osmium::index::map::Map<TId, TValue> {
+
+                static_assert(std::is_same<TValue, osmium::Location>::value,
+                              "CompressedMemArray can only store osmium::Location values");
+
+                // number of bits of ID used for the position inside a block
+                static constexpr unsigned block_bits = 10;
+
+                // number of bits of ID used for the position inside a chunk
+                static constexpr unsigned chunk_bits = 6;
+
+                // number of chunks in the decoded chunk cache (power of 2)
+                static constexpr size_t cache_size = 64;
+
+                // size of the pages where the compressed blocks are stored in
+                static constexpr size_t page_size = 4 * 1024 * 1024;
+
+                static constexpr size_t block_size = size_t(1) << block_bits;
+                static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+                static constexpr size_t chunks_per_block = block_size / chunk_size;
+
+                // every block starts with chunks_per_block+1 offsets
+                static constexpr size_t block_header_size = (chunks_per_block + 1) * sizeof(uint16_t);
+
+                static constexpr uint64_t no_block = std::numeric_limits<uint64_t>::max();
+
+                // offsets of the compressed blocks into the pages
+                std::vector<uint64_t> m_block_offsets;
+
+                // compressed data
+                std::vector<std::vector<char>> m_pages;
+
+                // uncompressed data of the block currently written to
+                std::vector<TValue> m_write_block;
+
+                uint64_t m_write_block_num = no_block;
+
+                // number of locations in all compressed blocks
+                size_t m_size = 0;
+
+                // number of bytes in compressed blocks that are not used any more
+                size_t m_garbage = 0;
+
+                mutable std::vector<TValue> m_cache;
+
+                // chunk number + 1 for each cache entry, 0 if unused
+                mutable std::vector<uint64_t> m_cache_tags;
+
+                const char* block_data(uint64_t offset) const noexcept {
+                    return m_pages[offset / page_size].data() + (offset % page_size);
+                }
+
+                static uint16_t chunk_offset(const char* block, size_t n) noexcept {
+                    uint16_t value;
+                    std::memcpy(&value, block + n * sizeof(uint16_t), sizeof(uint16_t));
+                    return value;
+                }
+
+                uint64_t block_offset(uint64_t block_num) const noexcept {
+                    if (block_num >= m_block_offsets.size()) {
+                        return no_block;
+                    }
+                    return m_block_offsets[block_num];
+                }
+
+                static void encode_chunk(std::string& out, const TValue* values) {
+                    int64_t last_id = -1;
+                    int64_t last_x = 0;
+                    int64_t last_y = 0;
+                    for (size_t n = 0; n < chunk_size; ++n) {
+                        const TValue& value = values[n];
+                        if (value == osmium::index::empty_value<TValue>()) {
+                            continue;
+                        }
+                        auto it = std::back_inserter(out);
+                        protozero::write_varint(it, static_cast<uint64_t>(int64_t(n) - last_id - 1));
+                        protozero::write_varint(it, protozero::encode_zigzag64(value.x() - last_x));
+                        protozero::write_varint(it, protozero::encode_zigzag64(value.y() - last_y));
+                        last_id = int64_t(n);
+                        last_x = value.x();
+                        last_y = value.y();
+                    }
+                }
+
+                static size_t decode_chunk(const char* data, const char* end, TValue* values) {
+                    std::fill(values, values + chunk_size, osmium::index::empty_value<TValue>());
+                    size_t count = 0;
+                    uint64_t pos = 0;
+                    int64_t x = 0;
+                    int64_t y = 0;
+                    while (data != end) {
+                        pos += protozero::decode_varint(&data, end);
+                        x += protozero::decode_zigzag64(protozero::decode_varint(&data, end));
+                        y += protozero::decode_zigzag64(protozero::decode_varint(&data, end));
+                        values[pos] = TValue{static_cast<int32_t>(x), static_cast<int32_t>(y)};
+                        ++pos;
+                        ++count;
+                    }
+                    return count;
+                }
+
+                static size_t decode_block(const char* block, TValue* values) {
+                    size_t count = 0;
+                    const char* data = block + block_header_size;
+                    for (size_t n = 0; n < chunks_per_block; ++n) {
+                        count += decode_chunk(data + chunk_offset(block, n),
+                                              data + chunk_offset(block, n + 1),
+                                              values + n * chunk_size);
+                    }
+                    return count;
+                }
+
+                static size_t encoded_block_size(const char* block) noexcept {
+                    return block_header_size + chunk_offset(block, chunks_per_block);
+                }
+
+                uint64_t append_data(const std::string& data) {
+                    if (m_pages.empty() || m_pages.back().size() + data.size() > page_size) {
+                        m_pages.emplace_back();
+                        m_pages.back().reserve(page_size);
+                    }
+                    auto& page = m_pages.back();
+                    const uint64_t offset = (m_pages.size() - 1) * page_size + page.size();
+                    page.insert(page.end(), data.begin(), data.end());
+                    return offset;
+                }
+
+                void invalidate_cache(uint64_t block_num) noexcept {
+                    for (size_t n = 0; n < chunks_per_block; ++n) {
+                        const uint64_t chunk_num = (block_num << (block_bits - chunk_bits)) + n;
+                        auto& tag = m_cache_tags[chunk_num & (cache_size - 1)];
+                        if (tag == chunk_num + 1) {
+                            tag = 0;
+                        }
+                    }
+                }
+
+                size_t write_block_count() const {
+                    if (m_write_block_num == no_block) {
+                        return 0;
+                    }
+                    return std::count_if(m_write_block.begin(), m_write_block.end(), [](const TValue& value) {
+                        return value != osmium::index::empty_value<TValue>();
+                    });
+                }
+
+                void flush_write_block() {
+                    if (m_write_block_num == no_block) {
+                        return;
+                    }
+
+                    std::string data(block_header_size, '\0');
+                    for (size_t n = 0; n < chunks_per_block; ++n) {
+                        const auto offset = static_cast<uint16_t>(data.size() - block_header_size);
+                        std::memcpy(&data[n * sizeof(uint16_t)], &offset, sizeof(uint16_t));
+                        encode_chunk(data, m_write_block.data() + n * chunk_size);
+                    }
+                    const auto offset = static_cast<uint16_t>(data.size() - block_header_size);
+                    std::memcpy(&data[chunks_per_block * sizeof(uint16_t)], &offset, sizeof(uint16_t));
+
+                    if (offset > 0) {
+                        if (m_write_block_num >= m_block_offsets.size()) {
+                            m_block_offsets.resize(m_write_block_num + 1, uint64_t(no_block));
+                        }
+                        m_block_offsets[m_write_block_num] = append_data(data);
+                        m_size += write_block_count();
+                    }
+
+                    m_write_block_num = no_block;
+                }
+
+                void load_write_block(uint64_t block_num) {
+                    m_write_block.resize(block_size);
+                    std::fill(m_write_block.begin(), m_write_block.end(), osmium::index::empty_value<TValue>());
+
+                    const uint64_t offset = block_offset(block_num);
+                    if (offset != no_block) {
+                        const char* block = block_data(offset);
+                        m_size -= decode_block(block, m_write_block.data());
+                        m_garbage += encoded_block_size(block);
+                        m_block_offsets[block_num] = no_block;
+                        invalidate_cache(block_num);
+                    }
+
+                    m_write_block_num = block_num;
+                }
+
+                // Returns the empty value if the id is not found.
+                TValue lookup(const TId id) const {
+                    const uint64_t block_num = id >> block_bits;
+                    if (block_num == m_write_block_num) {
+                        return m_write_block[id & (block_size - 1)];
+                    }
+
+                    const uint64_t chunk_num = id >> chunk_bits;
+                    const size_t slot = chunk_num & (cache_size - 1);
+                    TValue* values = m_cache.data() + slot * chunk_size;
+                    if (m_cache_tags[slot] != chunk_num + 1) {
+                        const uint64_t offset = block_offset(block_num);
+                        if (offset == no_block) {
+                            return osmium::index::empty_value<TValue>();
+                        }
+                        const char* block = block_data(offset);
+                        const size_t n = chunk_num & (chunks_per_block - 1);
+                        const char* data = block + block_header_size;
+                        decode_chunk(data + chunk_offset(block, n),
+                                     data + chunk_offset(block, n + 1),
+                                     values);
+                        m_cache_tags[slot] = chunk_num + 1;
+                    }
+
+                    return values[id & (chunk_size - 1)];
+                }
+
+            public:
+
+                CompressedMemArray() :
+                    m_cache(cache_size * chunk_size),
+                    m_cache_tags(cache_size, 0) {
+                }
+
+                ~CompressedMemArray() noexcept final = default;
+
+                void reserve(const size_t size) final {
+                    m_block_offsets.reserve((size >> block_bits) + 1);
+                }
+
+                void set(const TId id, const TValue value) final {
+                    const uint64_t block_num = id >> block_bits;
+                    if (block_num != m_write_block_num) {
+                        flush_write_block();
+                        load_write_block(block_num);
+                    }
+                    m_write_block[id & (block_size - 1)] = value;
+                }
+
+                const TValue get(const TId id) const final {
+                    const TValue value = lookup(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        not_found_error(id);
+                    }
+                    return value;
+                }
+
+                void get_many(const TId* ids, TValue* values, const size_t n) const final {
+                    for (size_t i = 0; i < n; ++i) {
+                        values[i] = lookup(ids[i]);
+                    }
+                }
+
+                /**
+                 * The number of locations stored in this index.
+                 */
+                size_t size() const final {
+                    return m_size + write_block_count();
+                }
+
+                size_t used_memory() const final {
+                    return m_block_offsets.capacity() * sizeof(uint64_t) +
+                           m_pages.size() * page_size +
+                           m_write_block.capacity() * sizeof(TValue) +
+                           m_cache.size() * sizeof(TValue);
+                }
+
+                /**
+                 * Number of bytes in the compressed data that are not used
+                 * any more, because blocks were re-written.
+                 */
+                size_t garbage() const noexcept {
+                    return m_garbage;
+                }
+
+                void clear() final {
+                    m_block_offsets.clear();
+                    m_block_offsets.shrink_to_fit();
+                    m_pages.clear();
+                    m_pages.shrink_to_fit();
+                    m_write_block.clear();
+                    m_write_block.shrink_to_fit();
+                    m_write_block_num = no_block;
+                    m_size = 0;
+                    m_garbage = 0;
+                    std::fill(m_cache_tags.begin(), m_cache_tags.end(), 0);
+                }
+
+                void sort() final {
+                    flush_write_block();
+                }
+
+                void dump_as_list(const int fd) final {
+                    flush_write_block();
+
+                    typedef typename std::pair<TId, TValue> element_type;
+                    std::vector<TValue> values(block_size);
+                    std::vector<element_type> v;
+                    v.reserve(block_size);
+
+                    for (uint64_t block_num = 0; block_num < m_block_offsets.size(); ++block_num) {
+                        const uint64_t offset = m_block_offsets[block_num];
+                        if (offset == no_block) {
+                            continue;
+                        }
+                        decode_block(block_data(offset), values.data());
+                        v.clear();
+                        for (size_t n = 0; n < block_size; ++n) {
+                            if (values[n] != osmium::index::empty_value<TValue>()) {
+                                v.emplace_back(static_cast<TId>((block_num << block_bits) + n), values[n]);
+                            }
+                        }
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(v.data()), sizeof(element_type) * v.size());
+                    }
+                }
+
+            }; // class CompressedMemArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MAP_COMPRESSED_MEM_ARRAY_HPP
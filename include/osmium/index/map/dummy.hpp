@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
 #include <cstddef>
 
 #include <osmium/index/index.hpp>
@@ -66,6 +67,10 @@ namespace osmium {
                     not_found_error(id);
                 }
 
+                void get_many(const TId*, TValue* values, const size_t n) const final {
+                    std::fill_n(values, n, osmium::index::empty_value<TValue>());
+                }
+
                 size_t size() const final {
                     return 0;
                 }
@@ -0,0 +1,188 @@
+#ifndef OSMIUM_INDEX_MAP_INDEX_FILE_MAP_HPP
+#define OSMIUM_INDEX_MAP_INDEX_FILE_MAP_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+#include <osmium/index/detail/vector_map.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/index_file.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#define OSMIUM_HAS_INDEX_MAP_INDEX_FILE_MAP
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Read-only map backed by an index file written with
+             * osmium::index::write_index_file(). The file is mapped into
+             * memory, the data is used as it is, without sorting or
+             * copying it. So opening even a large index file is instant.
+             *
+             * Works for dense and sparse index files. The header is checked
+             * when the file is opened, an osmium::index_file_error is
+             * thrown if the file doesn't fit.
+             */
+            template <typename TId, typename TValue>
+            class IndexFileMap : public Map<TId, TValue> {
+
+                typedef std::pair<TId, TValue> element_type;
+
+                index_file_header m_header;
+                osmium::util::MemoryMapping m_mapping;
+
+                const char* data() const {
+                    return m_mapping.get_addr<char>() + sizeof(index_file_header);
+                }
+
+                const TValue* values() const {
+                    return reinterpret_cast<const TValue*>(data());
+                }
+
+                const element_type* elements() const {
+                    return reinterpret_cast<const element_type*>(data());
+                }
+
+                bool dense() const noexcept {
+                    return m_header.data_type() == index_file_type::dense;
+                }
+
+            public:
+
+                /**
+                 * Open index file. The file descriptor can be closed
+                 * after this.
+                 *
+                 * @param fd File descriptor of index file open for reading.
+                 * @throws osmium::index_file_error if the file is not a
+                 *         valid index file for this map.
+                 */
+                explicit IndexFileMap(const int fd) :
+                    m_header(read_index_file_header(fd)),
+                    m_mapping((check_index_file_header<TId, TValue>(m_header, osmium::util::file_size(fd)),
+                               sizeof(index_file_header) + m_header.data_size()),
+                              osmium::util::MemoryMapping::mapping_mode::readonly,
+                              fd) {
+                }
+
+                ~IndexFileMap() noexcept final = default;
+
+                /// The header of the index file.
+                const index_file_header& header() const noexcept {
+                    return m_header;
+                }
+
+                void set(const TId /*id*/, const TValue /*value*/) final {
+                    throw std::runtime_error("can't set value in read-only index file map");
+                }
+
+                const TValue get(const TId id) const final {
+                    if (dense()) {
+                        if (id < m_header.num_elements) {
+                            const TValue value = values()[id];
+                            if (value != osmium::index::empty_value<TValue>()) {
+                                return value;
+                            }
+                        }
+                    } else {
+                        const element_type* first = elements();
+                        const element_type* last = first + m_header.num_elements;
+                        const element_type element {
+                            id,
+                            osmium::index::empty_value<TValue>()
+                        };
+                        const element_type* result = std::lower_bound(first, last, element, [](const element_type& a, const element_type& b) {
+                            return a.first < b.first;
+                        });
+                        if (result != last && result->first == id) {
+                            return result->second;
+                        }
+                    }
+                    not_found_error(id);
+                }
+
+                void get_many(const TId* ids, TValue* values_out, const size_t n) const final {
+                    if (dense()) {
+                        osmium::index::detail::dense_get_many(values(), size(), ids, values_out, n);
+                    } else {
+                        osmium::index::detail::sparse_get_many<TId, TValue>(elements(), size(), nullptr, ids, values_out, n);
+                    }
+                }
+
+                size_t size() const final {
+                    return static_cast<size_t>(m_header.num_elements);
+                }
+
+                size_t used_memory() const final {
+                    return m_mapping.size();
+                }
+
+                void clear() final {
+                    m_mapping.unmap();
+                    m_header.num_elements = 0;
+                }
+
+                void dump_as_array(const int fd) final {
+                    if (!dense()) {
+                        throw std::runtime_error("can't dump sparse index file as array");
+                    }
+                    osmium::io::detail::reliable_write(fd, data(), static_cast<size_t>(m_header.data_size()));
+                }
+
+                void dump_as_list(const int fd) final {
+                    if (dense()) {
+                        throw std::runtime_error("can't dump dense index file as list");
+                    }
+                    osmium::io::detail::reliable_write(fd, data(), static_cast<size_t>(m_header.data_size()));
+                }
+
+            }; // class IndexFileMap
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MAP_INDEX_FILE_MAP_HPP
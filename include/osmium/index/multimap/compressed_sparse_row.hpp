@@ -0,0 +1,350 @@
+#ifndef OSMIUM_INDEX_MULTIMAP_COMPRESSED_SPARSE_ROW_HPP
+#define OSMIUM_INDEX_MULTIMAP_COMPRESSED_SPARSE_ROW_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <osmium/index/detail/parallel_sort.hpp>
+#include <osmium/index/multimap.hpp>
+#include <osmium/io/detail/read_write.hpp>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace multimap {
+
+            /**
+             * Multimap in compressed sparse row (CSR) format: After sorting,
+             * all values are stored in one packed array, ordered by id. For
+             * each distinct id there is only an index into this array, so
+             * ids that occur several times are stored only once. The ids
+             * and indexes are stored as 32 bit differences to the start of
+             * blocks of up to 256 ids.
+             *
+             * For a node-to-way index with 64 bit ids and values this needs
+             * about 8 bytes per distinct id (two 32 bit differences) plus 8
+             * bytes per value, a fraction of what SparseMemMultimap needs.
+             *
+             * Elements added with set() are collected and only added to the
+             * compressed data in sort(), which uses the parallel sort from
+             * osmium::index::detail::sort_pairs(). Call sort() after
+             * adding elements and before calling get_all().
+             */
+            template <typename TId, typename TValue>
+            class CompressedSparseRowMultimap : public osmium::index::multimap::Multimap<TId, TValue> {
+
+            public:
+
+                typedef typename std::pair<TId, TValue> element_type;
+
+                /**
+                 * Iterator over the elements with the same id. Dereferences
+                 * to an std::pair<TId, TValue> like the iterators of the
+                 * other multimaps.
+                 */
+                class const_iterator {
+
+                    TId m_id;
+                    const TValue* m_value;
+                    mutable element_type m_element;
+
+                public:
+
+                    typedef std::forward_iterator_tag iterator_category;
+                    typedef element_type              value_type;
+                    typedef std::ptrdiff_t            difference_type;
+                    typedef const element_type*       pointer;
+                    typedef const element_type&       reference;
+
+                    const_iterator(const TId id, const TValue* value) noexcept :
+                        m_id(id),
+                        m_value(value),
+                        m_element() {
+                    }
+
+                    reference operator*() const {
+                        m_element.first = m_id;
+                        m_element.second = *m_value;
+                        return m_element;
+                    }
+
+                    pointer operator->() const {
+                        return &operator*();
+                    }
+
+                    const_iterator& operator++() noexcept {
+                        ++m_value;
+                        return *this;
+                    }
+
+                    const_iterator operator++(int) noexcept {
+                        const_iterator tmp(*this);
+                        ++m_value;
+                        return tmp;
+                    }
+
+                    bool operator==(const const_iterator& other) const noexcept {
+                        return m_value == other.m_value;
+                    }
+
+                    bool operator!=(const const_iterator& other) const noexcept {
+                        return !(*this == other);
+                    }
+
+                }; // class const_iterator
+
+                typedef const_iterator iterator;
+
+            private:
+
+                // Maximum number of ids in a block.
+                static constexpr size_t max_block_size = 256;
+
+                static constexpr uint64_t max_delta = std::numeric_limits<uint32_t>::max();
+
+                struct block {
+                    TId first_id;
+                    size_t first_key;
+                    size_t first_value;
+                };
+
+                // Elements added since the last sort().
+                std::vector<element_type> m_unsorted;
+
+                std::vector<block> m_blocks;
+
+                // For each distinct id: difference between the id and
+                // the first id of its block.
+                std::vector<uint32_t> m_id_deltas;
+
+                // For each distinct id: difference between the index of
+                // its first value and the first value of its block.
+                std::vector<uint32_t> m_value_deltas;
+
+                std::vector<TValue> m_values;
+
+                size_t value_begin(const block& b, const size_t key) const noexcept {
+                    return b.first_value + m_value_deltas[key];
+                }
+
+                // Add elements of the compressed data to m_unsorted.
+                void decompress() {
+                    m_unsorted.reserve(m_unsorted.size() + m_values.size());
+                    for (size_t b = 0; b < m_blocks.size(); ++b) {
+                        const size_t end_key = b + 1 < m_blocks.size() ? m_blocks[b + 1].first_key : m_id_deltas.size();
+                        for (size_t key = m_blocks[b].first_key; key < end_key; ++key) {
+                            const TId id = m_blocks[b].first_id + m_id_deltas[key];
+                            const size_t end_value = key + 1 < end_key ? value_begin(m_blocks[b], key + 1) :
+                                                     (b + 1 < m_blocks.size() ? m_blocks[b + 1].first_value : m_values.size());
+                            for (size_t v = value_begin(m_blocks[b], key); v < end_value; ++v) {
+                                m_unsorted.emplace_back(id, m_values[v]);
+                            }
+                        }
+                    }
+                }
+
+                void clear_compressed() {
+                    m_blocks.clear();
+                    m_blocks.shrink_to_fit();
+                    m_id_deltas.clear();
+                    m_id_deltas.shrink_to_fit();
+                    m_value_deltas.clear();
+                    m_value_deltas.shrink_to_fit();
+                    m_values.clear();
+                    m_values.shrink_to_fit();
+                }
+
+                // Build compressed data from the sorted m_unsorted.
+                void compress() {
+                    m_values.reserve(m_unsorted.size());
+
+                    for (size_t i = 0; i < m_unsorted.size(); ++i) {
+                        const TId id = m_unsorted[i].first;
+                        if (i == 0 || id != m_unsorted[i - 1].first) {
+                            if (m_blocks.empty() ||
+                                m_id_deltas.size() - m_blocks.back().first_key >= max_block_size ||
+                                static_cast<uint64_t>(id - m_blocks.back().first_id) > max_delta ||
+                                static_cast<uint64_t>(i - m_blocks.back().first_value) > max_delta) {
+                                m_blocks.push_back(block{id, m_id_deltas.size(), i});
+                            }
+                            m_id_deltas.push_back(static_cast<uint32_t>(id - m_blocks.back().first_id));
+                            m_value_deltas.push_back(static_cast<uint32_t>(i - m_blocks.back().first_value));
+                        }
+                        m_values.push_back(m_unsorted[i].second);
+                    }
+
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+                    m_blocks.shrink_to_fit();
+                    m_id_deltas.shrink_to_fit();
+                    m_value_deltas.shrink_to_fit();
+                }
+
+            public:
+
+                CompressedSparseRowMultimap() = default;
+
+                ~CompressedSparseRowMultimap() noexcept final = default;
+
+                void unsorted_set(const TId id, const TValue value) {
+                    m_unsorted.emplace_back(id, value);
+                }
+
+                void set(const TId id, const TValue value) final {
+                    m_unsorted.emplace_back(id, value);
+                }
+
+                /**
+                 * Get all elements with the given id. Only elements added
+                 * before the last call to sort() are found. The values are
+                 * sorted.
+                 */
+                std::pair<const_iterator, const_iterator> get_all(const TId id) const {
+                    const std::pair<const_iterator, const_iterator> empty{const_iterator{id, nullptr}, const_iterator{id, nullptr}};
+
+                    auto it = std::upper_bound(m_blocks.cbegin(), m_blocks.cend(), id, [](const TId i, const block& b) {
+                        return i < b.first_id;
+                    });
+                    if (it == m_blocks.cbegin()) {
+                        return empty;
+                    }
+                    --it;
+
+                    const uint64_t delta = static_cast<uint64_t>(id - it->first_id);
+                    if (delta > max_delta) {
+                        return empty;
+                    }
+
+                    const bool last_block = std::next(it) == m_blocks.cend();
+                    const size_t end_key = last_block ? m_id_deltas.size() : std::next(it)->first_key;
+                    const auto first = m_id_deltas.cbegin() + it->first_key;
+                    const auto last = m_id_deltas.cbegin() + end_key;
+                    const auto found = std::lower_bound(first, last, static_cast<uint32_t>(delta));
+                    if (found == last || *found != delta) {
+                        return empty;
+                    }
+
+                    const size_t key = static_cast<size_t>(found - m_id_deltas.cbegin());
+                    const size_t begin_value = value_begin(*it, key);
+                    const size_t end_value = key + 1 < end_key ? value_begin(*it, key + 1) :
+                                             (last_block ? m_values.size() : std::next(it)->first_value);
+
+                    return std::make_pair(const_iterator{id, m_values.data() + begin_value},
+                                          const_iterator{id, m_values.data() + end_value});
+                }
+
+                /// Number of distinct ids (after the last sort()).
+                size_t num_ids() const noexcept {
+                    return m_id_deltas.size();
+                }
+
+                size_t size() const final {
+                    return m_values.size() + m_unsorted.size();
+                }
+
+                size_t used_memory() const final {
+                    return m_unsorted.capacity() * sizeof(element_type) +
+                           m_blocks.capacity() * sizeof(block) +
+                           m_id_deltas.capacity() * sizeof(uint32_t) +
+                           m_value_deltas.capacity() * sizeof(uint32_t) +
+                           m_values.capacity() * sizeof(TValue);
+                }
+
+                void clear() final {
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+                    clear_compressed();
+                }
+
+                /**
+                 * Add the elements added with set() since the last call to
+                 * the compressed data. Large amounts of data are sorted in
+                 * parallel on the thread pool.
+                 */
+                void sort() final {
+                    if (m_unsorted.empty()) {
+                        return;
+                    }
+                    if (!m_values.empty()) {
+                        decompress();
+                        clear_compressed();
+                    }
+                    osmium::index::detail::sort_pairs(m_unsorted);
+                    compress();
+                }
+
+                void dump_as_list(const int fd) final {
+                    sort();
+
+                    std::vector<element_type> buffer;
+                    const size_t buffer_size = 64 * 1024;
+                    buffer.reserve(buffer_size);
+
+                    for (size_t b = 0; b < m_blocks.size(); ++b) {
+                        const size_t end_key = b + 1 < m_blocks.size() ? m_blocks[b + 1].first_key : m_id_deltas.size();
+                        const auto range_end = [&](size_t key) {
+                            return key + 1 < end_key ? value_begin(m_blocks[b], key + 1) :
+                                   (b + 1 < m_blocks.size() ? m_blocks[b + 1].first_value : m_values.size());
+                        };
+                        for (size_t key = m_blocks[b].first_key; key < end_key; ++key) {
+                            const TId id = m_blocks[b].first_id + m_id_deltas[key];
+                            for (size_t v = value_begin(m_blocks[b], key); v < range_end(key); ++v) {
+                                buffer.emplace_back(id, m_values[v]);
+                                if (buffer.size() == buffer_size) {
+                                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(buffer.data()), sizeof(element_type) * buffer.size());
+                                    buffer.clear();
+                                }
+                            }
+                        }
+                    }
+
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(buffer.data()), sizeof(element_type) * buffer.size());
+                }
+
+            }; // class CompressedSparseRowMultimap
+
+        } // namespace multimap
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MULTIMAP_COMPRESSED_SPARSE_ROW_HPP
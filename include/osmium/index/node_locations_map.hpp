@@ -33,7 +33,16 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <type_traits>
+#include <utility>
+
 #include <osmium/index/map.hpp> // IWYU pragma: keep
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#ifdef OSMIUM_HAS_INDEX_MAP_COMPRESSED_MEM_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedMemArray, compressed_mem_array)
+#endif
 
 #ifdef OSMIUM_HAS_INDEX_MAP_DENSE_FILE_ARRAY
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseFileArray, dense_file_array)
@@ -67,4 +76,103 @@ DEALINGS IN THE SOFTWARE.
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMmapArray, sparse_mmap_array)
 #endif
 
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            template <typename TFunc>
+            inline void call_with_concrete_map(osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>& map, TFunc&& func, std::true_type) {
+#ifdef OSMIUM_HAS_INDEX_MAP_COMPRESSED_MEM_ARRAY
+                if (auto* concrete_map = dynamic_cast<osmium::index::map::CompressedMemArray<osmium::unsigned_object_id_type, osmium::Location>*>(&map)) {
+                    func(*concrete_map);
+                    return;
+                }
+#endif
+#ifdef OSMIUM_HAS_INDEX_MAP_DENSE_FILE_ARRAY
+                if (auto* concrete_map = dynamic_cast<osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>*>(&map)) {
+                    func(*concrete_map);
+                    return;
+                }
+#endif
+#ifdef OSMIUM_HAS_INDEX_MAP_DENSE_MEM_ARRAY
+                if (auto* concrete_map = dynamic_cast<osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>*>(&map)) {
+                    func(*concrete_map);
+                    return;
+                }
+#endif
+#ifdef OSMIUM_HAS_INDEX_MAP_DENSE_MMAP_ARRAY
+                if (auto* concrete_map = dynamic_cast<osmium::index::map::DenseMmapArray<osmium::unsigned_object_id_type, osmium::Location>*>(&map)) {
+                    func(*concrete_map);
+                    return;
+                }
+#endif
+#ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_FILE_ARRAY
+                if (auto* concrete_map = dynamic_cast<osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location>*>(&map)) {
+                    func(*concrete_map);
+                    return;
+                }
+#endif
+#ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_MEM_ARRAY
+                if (auto* concrete_map = dynamic_cast<osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>*>(&map)) {
+                    func(*concrete_map);
+                    return;
+                }
+#endif
+#ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_MEM_MAP
+                if (auto* concrete_map = dynamic_cast<osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::Location>*>(&map)) {
+                    func(*concrete_map);
+                    return;
+                }
+#endif
+#ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_MEM_TABLE
+                if (auto* concrete_map = dynamic_cast<osmium::index::map::SparseMemTable<osmium::unsigned_object_id_type, osmium::Location>*>(&map)) {
+                    func(*concrete_map);
+                    return;
+                }
+#endif
+#ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_MMAP_ARRAY
+                if (auto* concrete_map = dynamic_cast<osmium::index::map::SparseMmapArray<osmium::unsigned_object_id_type, osmium::Location>*>(&map)) {
+                    func(*concrete_map);
+                    return;
+                }
+#endif
+                func(map);
+            }
+
+            template <typename TMap, typename TFunc>
+            inline void call_with_concrete_map(TMap& map, TFunc&& func, std::false_type) {
+                func(map);
+            }
+
+        } // namespace detail
+
+        /**
+         * Call func with the map cast to its concrete type. This allows
+         * handlers working on a map created at run-time through the
+         * MapFactory to run their inner loops on the concrete map type,
+         * so that calls to set() and get() are not virtual and can be
+         * inlined. Do this once for a whole buffer or more, not for every
+         * object, because a few dynamic_casts are needed to find the
+         * type.
+         *
+         * func must be callable with a reference to any of the map types
+         * (use a functor with a templated operator()). If the map is of a
+         * type not known here, or if TMap already is a concrete type, func
+         * is called with the map as is.
+         *
+         * Only map types whose headers were included before this header
+         * are known here.
+         */
+        template <typename TMap, typename TFunc>
+        inline void call_with_concrete_map(TMap& map, TFunc&& func) {
+            detail::call_with_concrete_map(map, std::forward<TFunc>(func),
+                std::is_same<TMap, osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>>{});
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
 #endif // OSMIUM_INDEX_NODE_LOCATIONS_MAP_HPP
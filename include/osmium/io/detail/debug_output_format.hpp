@@ -33,7 +33,6 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
-#include <cinttypes>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
@@ -160,7 +159,7 @@ namespace osmium {
 
                 void write_timestamp(const osmium::Timestamp& timestamp) {
                     if (timestamp.valid()) {
-                        *m_out += timestamp.to_iso();
+                        timestamp.to_iso_str(*m_out);
                         output_formatted(" (%d)", timestamp.seconds_since_epoch());
                     } else {
                         write_error("NOT SET");
@@ -169,7 +168,8 @@ namespace osmium {
                 }
 
                 void write_meta(const osmium::OSMObject& object) {
-                    output_formatted("%" PRId64 "\n", object.id());
+                    output_int(object.id());
+                    *m_out += '\n';
                     if (m_options.add_metadata) {
                         write_fieldname("version");
                         output_formatted("  %d", object.version());
@@ -213,9 +213,16 @@ namespace osmium {
                     }
                 }
 
+                void write_coordinates(const osmium::Location& location) {
+                    output_coordinate(location.x());
+                    *m_out += ',';
+                    output_coordinate(location.y());
+                }
+
                 void write_location(const osmium::Location& location) {
                     write_fieldname("lon/lat");
-                    output_formatted("  %.7f,%.7f", location.lon_without_check(), location.lat_without_check());
+                    *m_out += "  ";
+                    write_coordinates(location);
                     if (!location.valid()) {
                         write_error(" INVALID LOCATION!");
                     }
@@ -230,7 +237,9 @@ namespace osmium {
                     }
                     const auto& bl = box.bottom_left();
                     const auto& tr = box.top_right();
-                    output_formatted("%.7f,%.7f %.7f,%.7f", bl.lon_without_check(), bl.lat_without_check(), tr.lon_without_check(), tr.lat_without_check());
+                    write_coordinates(bl);
+                    *m_out += ' ';
+                    write_coordinates(tr);
                     if (!box.valid()) {
                         write_error(" INVALID BOX!");
                     }
@@ -299,9 +308,11 @@ namespace osmium {
                     int n = 0;
                     for (const auto& node_ref : way.nodes()) {
                         write_counter(width, n++);
-                        output_formatted("%10" PRId64, node_ref.ref());
+                        osmium::util::append_int(*m_out, node_ref.ref(), 10);
                         if (node_ref.location().valid()) {
-                            output_formatted(" (%.7f,%.7f)", node_ref.location().lon_without_check(), node_ref.location().lat_without_check());
+                            *m_out += " (";
+                            write_coordinates(node_ref.location());
+                            *m_out += ')';
                         }
                         *m_out += '\n';
                     }
@@ -323,7 +334,9 @@ namespace osmium {
                     for (const auto& member : relation.members()) {
                         write_counter(width, n++);
                         *m_out += short_typename[item_type_to_nwr_index(member.type())];
-                        output_formatted(" %10" PRId64 " ", member.ref());
+                        *m_out += ' ';
+                        osmium::util::append_int(*m_out, member.ref(), 10);
+                        *m_out += ' ';
                         write_string(member.role());
                         *m_out += '\n';
                     }
@@ -33,10 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
-#include <cinttypes>
 #include <cstddef>
 #include <cstdint>
-#include <cstdio>
 #include <future>
 #include <iterator>
 #include <memory>
@@ -88,13 +86,19 @@ namespace osmium {
                 }
 
                 void write_meta(const osmium::OSMObject& object) {
-                    output_formatted("%" PRId64, object.id());
+                    output_int(object.id());
                     if (m_options.add_metadata) {
-                        output_formatted(" v%d d", object.version());
+                        *m_out += " v";
+                        output_int(object.version());
+                        *m_out += " d";
                         *m_out += (object.visible() ? 'V' : 'D');
-                        output_formatted(" c%d t", object.changeset());
-                        *m_out += object.timestamp().to_iso();
-                        output_formatted(" i%d u", object.uid());
+                        *m_out += " c";
+                        output_int(object.changeset());
+                        *m_out += " t";
+                        object.timestamp().to_iso_str(*m_out);
+                        *m_out += " i";
+                        output_int(object.uid());
+                        *m_out += " u";
                         append_encoded_string(object.user());
                     }
                     *m_out += " T";
@@ -113,7 +117,12 @@ namespace osmium {
 
                 void write_location(const osmium::Location& location, const char x, const char y) {
                     if (location) {
-                        output_formatted(" %c%.7f %c%.7f", x, location.lon_without_check(), y, location.lat_without_check());
+                        *m_out += ' ';
+                        *m_out += x;
+                        output_coordinate(location.x());
+                        *m_out += ' ';
+                        *m_out += y;
+                        output_coordinate(location.y());
                     } else {
                         *m_out += ' ';
                         *m_out += x;
@@ -166,7 +175,8 @@ namespace osmium {
                         } else {
                             *m_out += ',';
                         }
-                        output_formatted("n%" PRId64, node_ref.ref());
+                        *m_out += 'n';
+                        output_int(node_ref.ref());
                     }
                     *m_out += '\n';
                 }
@@ -184,18 +194,27 @@ namespace osmium {
                             *m_out += ',';
                         }
                         *m_out += item_type_to_char(member.type());
-                        output_formatted("%" PRId64 "@", member.ref());
+                        output_int(member.ref());
+                        *m_out += '@';
                         append_encoded_string(member.role());
                     }
                     *m_out += '\n';
                 }
 
                 void changeset(const osmium::Changeset& changeset) {
-                    output_formatted("c%d k%d s", changeset.id(), changeset.num_changes());
-                    *m_out += changeset.created_at().to_iso();
+                    *m_out += 'c';
+                    output_int(changeset.id());
+                    *m_out += " k";
+                    output_int(changeset.num_changes());
+                    *m_out += " s";
+                    changeset.created_at().to_iso_str(*m_out);
                     *m_out += " e";
-                    *m_out += changeset.closed_at().to_iso();
-                    output_formatted(" d%d i%d u", changeset.num_comments(), changeset.uid());
+                    changeset.closed_at().to_iso_str(*m_out);
+                    *m_out += " d";
+                    output_int(changeset.num_comments());
+                    *m_out += " i";
+                    output_int(changeset.uid());
+                    *m_out += " u";
                     append_encoded_string(changeset.user());
                     write_location(changeset.bounds().bottom_left(), 'x', 'y');
                     write_location(changeset.bounds().top_right(), 'X', 'Y');
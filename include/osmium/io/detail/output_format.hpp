@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
@@ -46,6 +47,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/util/number_format.hpp>
 
 namespace osmium {
 
@@ -75,6 +77,19 @@ namespace osmium {
                     append_printf_formatted_string(*m_out, format, std::forward<TArgs>(args)...);
                 }
 
+                template <typename T>
+                void output_int(T value) {
+                    osmium::util::append_int(*m_out, value);
+                }
+
+                /**
+                 * Write a coordinate of a Location (as returned by x() or
+                 * y()) with 7 digits after the decimal point.
+                 */
+                void output_coordinate(int32_t value) {
+                    osmium::util::append_fixed_point(*m_out, value, 7);
+                }
+
             }; // class OutputBlock;
 
             /**
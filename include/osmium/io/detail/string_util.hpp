@@ -34,6 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <string>
@@ -121,42 +122,159 @@ namespace osmium {
                 out.resize(old_size + size_t(len));
             }
 
+            /**
+             * Helper functions looking at 8 bytes of a string at a time
+             * packed into a 64 bit integer ("SIMD within a register").
+             * This is used to quickly find the next character in a string
+             * that needs escaping. All functions checking a word return
+             * non-zero if any of the 8 bytes matches. They never miss a
+             * match, the return value doesn't tell which byte matched.
+             */
+            namespace swar {
+
+                using word_type = uint64_t;
+
+                constexpr const word_type ones  = 0x0101010101010101ULL;
+                constexpr const word_type highs = 0x8080808080808080ULL;
+
+                inline word_type load(const char* data) noexcept {
+                    word_type word;
+                    std::memcpy(&word, data, sizeof(word_type));
+                    return word;
+                }
+
+                constexpr word_type has_zero_byte(word_type word) noexcept {
+                    return (word - ones) & ~word & highs;
+                }
+
+                constexpr word_type has_byte(word_type word, unsigned char c) noexcept {
+                    return has_zero_byte(word ^ (ones * c));
+                }
+
+                // n must be <= 128
+                constexpr word_type has_byte_less_than(word_type word, unsigned char n) noexcept {
+                    return (word - ones * n) & ~word & highs;
+                }
+
+                constexpr word_type has_non_ascii_byte(word_type word) noexcept {
+                    return word & highs;
+                }
+
+                /**
+                 * Find the first character in the range [data, end) for
+                 * which the predicate TByteCheck is true. TWordCheck must
+                 * return true for any word containing such a character.
+                 */
+                template <typename TWordCheck, typename TByteCheck>
+                inline const char* find_first(const char* data, const char* end, TWordCheck word_check, TByteCheck byte_check) noexcept {
+                    while (end - data >= static_cast<std::ptrdiff_t>(sizeof(word_type)) && !word_check(load(data))) {
+                        data += sizeof(word_type);
+                    }
+                    while (data != end && !byte_check(*data)) {
+                        ++data;
+                    }
+                    return data;
+                }
+
+            } // namespace swar
+
+            /**
+             * Append value as lowercase hex number with at least
+             * min_digits digits. Same as printf format "%0*x".
+             */
+            inline void append_lowercase_hex(std::string& out, uint32_t value, int min_digits) {
+                static const char* lookup_hex = "0123456789abcdef";
+                int digits = 1;
+                while (digits < 8 && (value >> (4 * digits)) != 0) {
+                    ++digits;
+                }
+                for (int shift = 4 * (digits > min_digits ? digits : min_digits) - 4; shift >= 0; shift -= 4) {
+                    out += lookup_hex[(value >> shift) & 0xfu];
+                }
+            }
+
+            // ASCII characters that are written unchanged in OPL files.
+            // Generally we don't want to let through any character that
+            // has special meaning in the OPL format such as space, comma,
+            // @, etc. and any non-printing characters.
+            inline bool is_opl_plain_char(char c) noexcept {
+                return (0x21 <= c && c <= 0x24) ||
+                       (0x26 <= c && c <= 0x2b) ||
+                       (0x2d <= c && c <= 0x3c) ||
+                       (0x3e <= c && c <= 0x3f) ||
+                       (0x41 <= c && c <= 0x7e);
+            }
+
+            inline swar::word_type has_opl_special_char(swar::word_type word) noexcept {
+                return swar::has_non_ascii_byte(word) |
+                       swar::has_byte_less_than(word, 0x21) |
+                       swar::has_byte(word, '%') |
+                       swar::has_byte(word, ',') |
+                       swar::has_byte(word, '=') |
+                       swar::has_byte(word, '@') |
+                       swar::has_byte(word, 0x7f);
+            }
+
             inline void append_utf8_encoded_string(std::string& out, const char* data) {
                 const char* end = data + std::strlen(data);
 
                 while (data != end) {
+                    // Copy plain ASCII characters in bulk.
+                    const char* plain_end = swar::find_first(data, end, has_opl_special_char, [](char c) {
+                        return !is_opl_plain_char(c);
+                    });
+                    out.append(data, plain_end);
+                    data = plain_end;
+                    if (data == end) {
+                        break;
+                    }
+
                     const char* last = data;
                     uint32_t c = utf8::next(data, end);
 
                     // This is a list of Unicode code points that we let
                     // through instead of escaping them. It is incomplete
                     // and can be extended later.
-                    // Generally we don't want to let through any character
-                    // that has special meaning in the OPL format such as
-                    // space, comma, @, etc. and any non-printing characters.
-                    if ((0x0021 <= c && c <= 0x0024) ||
-                        (0x0026 <= c && c <= 0x002b) ||
-                        (0x002d <= c && c <= 0x003c) ||
-                        (0x003e <= c && c <= 0x003f) ||
-                        (0x0041 <= c && c <= 0x007e) ||
-                        (0x00a1 <= c && c <= 0x00ac) ||
+                    if ((0x00a1 <= c && c <= 0x00ac) ||
                         (0x00ae <= c && c <= 0x05ff)) {
                         out.append(last, data);
                     } else {
                         out += '%';
-                        if (c <= 0xff) {
-                            append_printf_formatted_string(out, "%02x", c);
-                        } else {
-                            append_printf_formatted_string(out, "%04x", c);
-                        }
+                        append_lowercase_hex(out, c, c <= 0xff ? 2 : 4);
                         out += '%';
                     }
                 }
             }
 
+            inline bool is_xml_special_char(char c) noexcept {
+                return c == '&' || c == '\"' || c == '\'' || c == '<' || c == '>' ||
+                       c == '\n' || c == '\r' || c == '\t';
+            }
+
+            inline swar::word_type has_xml_special_char(swar::word_type word) noexcept {
+                return swar::has_byte(word, '&') |
+                       swar::has_byte(word, '\"') |
+                       swar::has_byte(word, '\'') |
+                       swar::has_byte(word, '<') |
+                       swar::has_byte(word, '>') |
+                       swar::has_byte(word, '\n') |
+                       swar::has_byte(word, '\r') |
+                       swar::has_byte(word, '\t');
+            }
+
             inline void append_xml_encoded_string(std::string& out, const char* data) {
-                for (; *data != '\0'; ++data) {
-                    switch(*data) {
+                const char* end = data + std::strlen(data);
+
+                while (data != end) {
+                    // Copy characters not needing escaping in bulk.
+                    const char* plain_end = swar::find_first(data, end, has_xml_special_char, is_xml_special_char);
+                    out.append(data, plain_end);
+                    data = plain_end;
+                    if (data == end) {
+                        break;
+                    }
+
+                    switch (*data) {
                         case '&':  out += "&amp;";  break;
                         case '\"': out += "&quot;"; break;
                         case '\'': out += "&apos;"; break;
@@ -164,9 +282,9 @@ namespace osmium {
                         case '>':  out += "&gt;";   break;
                         case '\n': out += "&#xA;";  break;
                         case '\r': out += "&#xD;";  break;
-                        case '\t': out += "&#x9;";  break;
-                        default:   out += *data;    break;
+                        default:   out += "&#x9;";  break; // '\t'
                     }
+                    ++data;
                 }
             }
 
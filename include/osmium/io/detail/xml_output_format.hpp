@@ -34,9 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <algorithm>
-#include <cinttypes>
 #include <cstddef>
-#include <cstdio>
 #include <future>
 #include <iterator>
 #include <memory>
@@ -117,27 +115,35 @@ namespace osmium {
                 }
 
                 void write_meta(const osmium::OSMObject& object) {
-                    output_formatted(" id=\"%" PRId64 "\"", object.id());
+                    *m_out += " id=\"";
+                    output_int(object.id());
+                    *m_out += '"';
 
                     if (m_options.add_metadata) {
                         if (object.version()) {
-                            output_formatted(" version=\"%d\"", object.version());
+                            *m_out += " version=\"";
+                            output_int(object.version());
+                            *m_out += '"';
                         }
 
                         if (object.timestamp()) {
                             *m_out += " timestamp=\"";
-                            *m_out += object.timestamp().to_iso();
+                            object.timestamp().to_iso_str(*m_out);
                             *m_out += "\"";
                         }
 
                         if (!object.user_is_anonymous()) {
-                            output_formatted(" uid=\"%d\" user=\"", object.uid());
+                            *m_out += " uid=\"";
+                            output_int(object.uid());
+                            *m_out += "\" user=\"";
                             append_xml_encoded_string(*m_out, object.user());
                             *m_out += "\"";
                         }
 
                         if (object.changeset()) {
-                            output_formatted(" changeset=\"%d\"", object.changeset());
+                            *m_out += " changeset=\"";
+                            output_int(object.changeset());
+                            *m_out += '"';
                         }
 
                         if (m_options.add_visible_flag) {
@@ -163,10 +169,12 @@ namespace osmium {
 
                 void write_discussion(const osmium::ChangesetDiscussion& comments) {
                     for (const auto& comment : comments) {
-                        output_formatted("   <comment uid=\"%d\" user=\"", comment.uid());
+                        *m_out += "   <comment uid=\"";
+                        output_int(comment.uid());
+                        *m_out += "\" user=\"";
                         append_xml_encoded_string(*m_out, comment.user());
                         *m_out += "\" date=\"";
-                        *m_out += comment.date().to_iso();
+                        comment.date().to_iso_str(*m_out);
                         *m_out += "\">\n";
                         *m_out += "    <text>";
                         append_xml_encoded_string(*m_out, comment.text());
@@ -289,7 +297,9 @@ namespace osmium {
 
                     for (const auto& node_ref : way.nodes()) {
                         write_prefix();
-                        output_formatted("  <nd ref=\"%" PRId64 "\"/>\n", node_ref.ref());
+                        *m_out += "  <nd ref=\"";
+                        output_int(node_ref.ref());
+                        *m_out += "\"/>\n";
                     }
 
                     write_tags(way.tags(), prefix_spaces());
@@ -318,7 +328,9 @@ namespace osmium {
                         write_prefix();
                         *m_out += "  <member type=\"";
                         *m_out += item_type_to_name(member.type());
-                        output_formatted("\" ref=\"%" PRId64 "\" role=\"", member.ref());
+                        *m_out += "\" ref=\"";
+                        output_int(member.ref());
+                        *m_out += "\" role=\"";
                         append_xml_encoded_string(*m_out, member.role());
                         *m_out += "\"/>\n";
                     }
@@ -332,17 +344,19 @@ namespace osmium {
                 void changeset(const osmium::Changeset& changeset) {
                     *m_out += " <changeset";
 
-                    output_formatted(" id=\"%" PRId32 "\"", changeset.id());
+                    *m_out += " id=\"";
+                    output_int(changeset.id());
+                    *m_out += '"';
 
                     if (changeset.created_at()) {
                         *m_out += " created_at=\"";
-                        *m_out += changeset.created_at().to_iso();
+                        changeset.created_at().to_iso_str(*m_out);
                         *m_out += "\"";
                     }
 
                     if (changeset.closed_at()) {
                         *m_out += " closed_at=\"";
-                        *m_out += changeset.closed_at().to_iso();
+                        changeset.closed_at().to_iso_str(*m_out);
                         *m_out += "\" open=\"false\"";
                     } else {
                         *m_out += " open=\"true\"";
@@ -351,18 +365,28 @@ namespace osmium {
                     if (!changeset.user_is_anonymous()) {
                         *m_out += " user=\"";
                         append_xml_encoded_string(*m_out, changeset.user());
-                        output_formatted("\" uid=\"%d\"", changeset.uid());
+                        *m_out += "\" uid=\"";
+                        output_int(changeset.uid());
+                        *m_out += '"';
                     }
 
                     if (changeset.bounds()) {
-                        output_formatted(" min_lat=\"%.7f\"", changeset.bounds().bottom_left().lat_without_check());
-                        output_formatted(" min_lon=\"%.7f\"", changeset.bounds().bottom_left().lon_without_check());
-                        output_formatted(" max_lat=\"%.7f\"", changeset.bounds().top_right().lat_without_check());
-                        output_formatted(" max_lon=\"%.7f\"", changeset.bounds().top_right().lon_without_check());
+                        *m_out += " min_lat=\"";
+                        output_coordinate(changeset.bounds().bottom_left().y());
+                        *m_out += "\" min_lon=\"";
+                        output_coordinate(changeset.bounds().bottom_left().x());
+                        *m_out += "\" max_lat=\"";
+                        output_coordinate(changeset.bounds().top_right().y());
+                        *m_out += "\" max_lon=\"";
+                        output_coordinate(changeset.bounds().top_right().x());
+                        *m_out += '"';
                     }
 
-                    output_formatted(" num_changes=\"%" PRId32 "\"", changeset.num_changes());
-                    output_formatted(" comments_count=\"%" PRId32 "\"", changeset.num_comments());
+                    *m_out += " num_changes=\"";
+                    output_int(changeset.num_changes());
+                    *m_out += "\" comments_count=\"";
+                    output_int(changeset.num_comments());
+                    *m_out += '"';
 
                     // If there are no tags and no comments, we can close the
                     // tag right here and are done.
@@ -34,7 +34,9 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <iosfwd>
 #include <stdexcept>
 #include <string>
@@ -280,6 +282,35 @@ namespace osmium {
         return out;
     }
 
+    namespace detail {
+
+        template <int N>
+        inline size_t hash(const osmium::Location& location) noexcept {
+            return static_cast<uint32_t>(location.x()) ^ static_cast<uint32_t>(location.y());
+        }
+
+        template <>
+        inline size_t hash<8>(const osmium::Location& location) noexcept {
+            uint64_t h = static_cast<uint32_t>(location.x());
+            h <<= 32;
+            return static_cast<size_t>(h ^ static_cast<uint32_t>(location.y()));
+        }
+
+    } // namespace detail
+
 } // namespace osmium
 
+namespace std {
+
+    template <>
+    struct hash<osmium::Location> {
+        typedef osmium::Location argument_type;
+        typedef size_t result_type;
+        size_t operator()(const osmium::Location& location) const noexcept {
+            return osmium::detail::hash<sizeof(size_t)>(location);
+        }
+    };
+
+} // namespace std
+
 #endif // OSMIUM_OSM_LOCATION_HPP
@@ -45,6 +45,74 @@ DEALINGS IN THE SOFTWARE.
 
 namespace osmium {
 
+    namespace detail {
+
+        /**
+         * Number of days between 1970-01-01 and the given date in the
+         * proleptic Gregorian calendar. Uses the algorithm from
+         * http://howardhinnant.github.io/date_algorithms.html .
+         */
+        inline int64_t days_from_civil(int64_t year, int month, int day) noexcept {
+            year -= month <= 2 ? 1 : 0;
+            const int64_t era = (year >= 0 ? year : year - 399) / 400;
+            const int64_t year_of_era = year - era * 400;
+            const int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+            const int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+            return era * 146097 + day_of_era - 719468;
+        }
+
+        /**
+         * Year, month, and day of the date the given number of days after
+         * 1970-01-01. This is the inverse of days_from_civil().
+         */
+        inline void civil_from_days(int64_t days, int64_t& year, int& month, int& day) noexcept {
+            days += 719468;
+            const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+            const int64_t day_of_era = days - era * 146097;
+            const int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+            const int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+            const int64_t mp = (5 * day_of_year + 2) / 153;
+            day = static_cast<int>(day_of_year - (153 * mp + 2) / 5 + 1);
+            month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+            year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+        }
+
+        inline bool is_leap_year(int64_t year) noexcept {
+            return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        }
+
+        inline int days_in_month(int64_t year, int month) noexcept {
+            static const int days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+            return (month == 2 && is_leap_year(year)) ? 29 : days[month - 1];
+        }
+
+        /**
+         * Parse count decimal digits at str.
+         *
+         * @returns the value or -1 if one of the characters isn't a digit.
+         */
+        inline int parse_digits(const char* str, int count) noexcept {
+            int value = 0;
+            for (int i = 0; i < count; ++i) {
+                if (str[i] < '0' || str[i] > '9') {
+                    return -1;
+                }
+                value = value * 10 + (str[i] - '0');
+            }
+            return value;
+        }
+
+        inline void append_digits(std::string& out, int value, int count) {
+            char buffer[4];
+            for (int i = count - 1; i >= 0; --i) {
+                buffer[i] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            }
+            out.append(buffer, static_cast<std::string::size_type>(count));
+        }
+
+    } // namespace detail
+
     /**
      * A timestamp. Internal representation is an unsigned 32bit integer
      * holding seconds since epoch (1970-01-01T00:00:00Z), so this will
@@ -54,15 +122,8 @@ namespace osmium {
      */
     class Timestamp {
 
-        // length of ISO timestamp string yyyy-mm-ddThh:mm:ssZ\0
-        static constexpr int timestamp_length = 20 + 1;
-
-        // The timestamp format for OSM timestamps in strftime(3) format.
-        // This is the ISO-Format "yyyy-mm-ddThh:mm:ssZ".
-        static const char* timestamp_format() {
-            static const char f[timestamp_length] = "%Y-%m-%dT%H:%M:%SZ";
-            return f;
-        }
+        // length of ISO timestamp string yyyy-mm-ddThh:mm:ssZ
+        static constexpr int timestamp_length = 20;
 
         uint32_t m_timestamp;
 
@@ -96,27 +157,22 @@ namespace osmium {
          * @throws std::invalid_argument if the timestamp can not be parsed.
          */
         explicit Timestamp(const char* timestamp) {
-#ifndef _WIN32
-            struct tm tm {
-                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-            };
-            if (strptime(timestamp, timestamp_format(), &tm) == nullptr) {
-                throw std::invalid_argument("can't parse timestamp");
-            }
-            m_timestamp = static_cast<uint32_t>(timegm(&tm));
-#else
-            struct tm tm;
-            int n = sscanf(timestamp, "%4d-%2d-%2dT%2d:%2d:%2dZ", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
-            if (n != 6) {
+            const int year   = detail::parse_digits(timestamp, 4);
+            const int month  = year   < 0 || timestamp[4]  != '-' ? -1 : detail::parse_digits(timestamp + 5, 2);
+            const int day    = month  < 0 || timestamp[7]  != '-' ? -1 : detail::parse_digits(timestamp + 8, 2);
+            const int hour   = day    < 0 || timestamp[10] != 'T' ? -1 : detail::parse_digits(timestamp + 11, 2);
+            const int minute = hour   < 0 || timestamp[13] != ':' ? -1 : detail::parse_digits(timestamp + 14, 2);
+            const int second = minute < 0 || timestamp[16] != ':' ? -1 : detail::parse_digits(timestamp + 17, 2);
+
+            if (second < 0 || timestamp[19] != 'Z' ||
+                month < 1 || month > 12 ||
+                day < 1 || day > detail::days_in_month(year, month) ||
+                hour > 23 || minute > 59 || second > 60) {
                 throw std::invalid_argument("can't parse timestamp");
             }
-            tm.tm_year -= 1900;
-            tm.tm_mon--;
-            tm.tm_wday = 0;
-            tm.tm_yday = 0;
-            tm.tm_isdst = 0;
-            m_timestamp = static_cast<uint32_t>(_mkgmtime(&tm));
-#endif
+
+            const int64_t days = detail::days_from_civil(year, month, day);
+            m_timestamp = static_cast<uint32_t>(days * 86400 + hour * 3600 + minute * 60 + second);
         }
 
         /**
@@ -176,31 +232,44 @@ namespace osmium {
             m_timestamp -= time_difference;
         }
 
+        /**
+         * Append UTC Unix time as string in ISO date/time
+         * ("yyyy-mm-ddThh:mm:ssZ") format to the given string. Nothing
+         * is appended for an invalid timestamp.
+         */
+        void to_iso_str(std::string& out) const {
+            if (m_timestamp == 0) {
+                return;
+            }
+
+            int64_t year;
+            int month;
+            int day;
+            detail::civil_from_days(m_timestamp / 86400, year, month, day);
+            const uint32_t seconds_of_day = m_timestamp % 86400;
+
+            out.reserve(out.size() + timestamp_length);
+            detail::append_digits(out, static_cast<int>(year), 4);
+            out += '-';
+            detail::append_digits(out, month, 2);
+            out += '-';
+            detail::append_digits(out, day, 2);
+            out += 'T';
+            detail::append_digits(out, static_cast<int>(seconds_of_day / 3600), 2);
+            out += ':';
+            detail::append_digits(out, static_cast<int>(seconds_of_day / 60 % 60), 2);
+            out += ':';
+            detail::append_digits(out, static_cast<int>(seconds_of_day % 60), 2);
+            out += 'Z';
+        }
+
         /**
          * Return UTC Unix time as string in ISO date/time
          * ("yyyy-mm-ddThh:mm:ssZ") format.
          */
         std::string to_iso() const {
             std::string s;
-
-            if (m_timestamp != 0) {
-                struct tm tm;
-                time_t sse = seconds_since_epoch();
-#ifndef _MSC_VER
-                gmtime_r(&sse, &tm);
-#else
-                gmtime_s(&tm, &sse);
-#endif
-
-                s.resize(timestamp_length);
-                /* This const_cast is ok, because we know we have enough space
-                in the string for the format we are using (well at least until
-                the year will have 5 digits). And by setting the size
-                afterwards from the result of strftime we make sure thats set
-                right, too. */
-                s.resize(strftime(const_cast<char*>(s.c_str()), timestamp_length, timestamp_format(), &tm));
-            }
-
+            to_iso_str(s);
             return s;
         }
 
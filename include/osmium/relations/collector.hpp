@@ -40,6 +40,8 @@ DEALINGS IN THE SOFTWARE.
 #include <functional>
 #include <iomanip>
 //#include <iostream>
+#include <limits>
+#include <memory>
 #include <vector>
 
 #include <osmium/fwd.hpp>
@@ -48,10 +50,12 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/relation.hpp> // IWYU pragma: keep
 #include <osmium/osm/types.hpp>
 #include <osmium/handler.hpp>
+#include <osmium/index/detail/mmap_vector_file.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/visitor.hpp>
 
 #include <osmium/relations/detail/relation_meta.hpp>
+#include <osmium/relations/detail/member_filter.hpp>
 #include <osmium/relations/detail/member_meta.hpp>
 
 namespace osmium {
@@ -168,6 +172,18 @@ namespace osmium {
             // All members we are interested in will be kept in this buffer
             osmium::memory::Buffer m_members_buffer;
 
+            // If the members buffer needs more than this many bytes, it is
+            // moved into m_members_file.
+            size_t m_members_memory_budget = std::numeric_limits<size_t>::max();
+
+            // Memory mapped temporary file holding the data of the members
+            // buffer if it was spilled to disk.
+            std::unique_ptr<osmium::detail::mmap_vector_file<unsigned char>> m_members_file;
+
+            // Size of the member objects marked as removed in the members
+            // buffer which have not been purged yet.
+            size_t m_removed_members_size = 0;
+
             /// Vector with all relations we are interested in
             std::vector<RelationMeta> m_relations;
 
@@ -177,13 +193,99 @@ namespace osmium {
              */
             std::vector<MemberMeta> m_member_meta[3];
 
+            /**
+             * Filters for quickly rejecting objects which are not a member
+             * of any relation we are interested in, one for each of the
+             * m_member_meta vectors.
+             */
+            MemberFilter m_member_filter[3];
+
             int m_count_complete = 0;
 
+            // Set when the MemberMetas marked as removed should be erased
+            // after the current object is handled.
+            bool m_must_erase_removed_member_metas = false;
+
             typedef std::function<void(osmium::memory::Buffer&&)> callback_func_type;
             callback_func_type m_callback;
 
             static constexpr size_t initial_buffer_size = 1024 * 1024;
 
+            // Removed members are not purged before there are at least
+            // this many bytes of them.
+            static constexpr size_t min_purge_size = 1024 * 1024;
+
+            // The temporary file for the members buffer grows in steps of
+            // at least this size.
+            static constexpr size_t members_file_increment = 64 * 1024 * 1024;
+
+            void purge_removed_members() {
+                m_members_buffer.purge_removed(this);
+                m_removed_members_size = 0;
+            }
+
+            // Return the capacity the members buffer would have after
+            // growing to hold needed bytes. The buffer doubles its
+            // capacity until the data fits.
+            size_t capacity_after_growth(size_t needed) const noexcept {
+                size_t capacity = m_members_buffer.capacity();
+                while (needed > capacity) {
+                    capacity *= 2;
+                }
+                return capacity;
+            }
+
+            // Is there room for needed bytes in the members buffer without
+            // the data or the memory allocated for it going over the
+            // memory budget?
+            bool fits_into_budget(size_t needed) const noexcept {
+                return needed <= m_members_memory_budget &&
+                       capacity_after_growth(needed) <= std::max(m_members_buffer.capacity(), m_members_memory_budget);
+            }
+
+            // Make sure there is room for size more bytes in the members
+            // buffer. If it would go over the memory budget, the removed
+            // objects are purged first. If that doesn't help, the buffer
+            // grows only up to the budget and, once that is full, it is
+            // moved to a temporary file.
+            void reserve_space_for_member(size_t size) {
+                const size_t needed = m_members_buffer.committed() + size;
+                if (m_members_file) {
+                    if (needed > m_members_buffer.capacity()) {
+                        const size_t committed = m_members_buffer.committed();
+                        const size_t capacity = std::max(committed * 2, needed + members_file_increment);
+                        m_members_file->reserve(capacity - capacity % members_file_increment);
+                        m_members_buffer = osmium::memory::Buffer(m_members_file->data(), m_members_file->capacity(), committed);
+                    }
+                    return;
+                }
+
+                if (fits_into_budget(needed)) {
+                    return;
+                }
+
+                if (m_removed_members_size > 0) {
+                    purge_removed_members();
+                    if (fits_into_budget(m_members_buffer.committed() + size)) {
+                        return;
+                    }
+                }
+
+                const size_t committed = m_members_buffer.committed();
+                if (committed + size <= m_members_memory_budget) {
+                    // Doubling the capacity would go over the budget, so
+                    // grow the buffer only as far as the budget allows.
+                    m_members_buffer.grow(m_members_memory_budget - m_members_memory_budget % osmium::memory::align_bytes);
+                    return;
+                }
+
+                const size_t capacity = std::max(committed * 2, committed + size + members_file_increment);
+                m_members_file.reset(new osmium::detail::mmap_vector_file<unsigned char>());
+                m_members_file->reserve(capacity - capacity % members_file_increment);
+                std::copy_n(m_members_buffer.data(), committed, m_members_file->data());
+                m_members_buffer = osmium::memory::Buffer(m_members_file->data(), m_members_file->capacity(), committed);
+            }
+
         public:
 
             /**
@@ -203,6 +305,10 @@ namespace osmium {
                 return m_member_meta[static_cast<uint16_t>(type) - 1];
             }
 
+            const MemberFilter& member_filter(const item_type type) const {
+                return m_member_filter[static_cast<uint16_t>(type) - 1];
+            }
+
             callback_func_type callback() {
                 return m_callback;
             }
@@ -357,6 +463,12 @@ namespace osmium {
                 std::sort(m_member_meta[0].begin(), m_member_meta[0].end());
                 std::sort(m_member_meta[1].begin(), m_member_meta[1].end());
                 std::sort(m_member_meta[2].begin(), m_member_meta[2].end());
+                for (int i = 0; i < 3; ++i) {
+                    m_member_filter[i].reset(m_member_meta[i].size());
+                    for (const auto& mm : m_member_meta[i]) {
+                        m_member_filter[i].add(mm.member_id());
+                    }
+                }
             }
 
             /**
@@ -367,6 +479,10 @@ namespace osmium {
              *          relation and false otherwise
              */
             bool find_and_add_object(const osmium::OSMObject& object) {
+                if (!member_filter(object.type()).might_contain(object.id())) {
+                    return false;
+                }
+
                 auto& mmv = member_meta(object.type());
                 auto range = std::equal_range(mmv.begin(), mmv.end(), MemberMeta(object.id()));
 
@@ -376,6 +492,7 @@ namespace osmium {
                 }
 
                 {
+                    reserve_space_for_member(object.padded_size());
                     members_buffer().add_item(object);
                     const size_t member_offset = members_buffer().commit();
 
@@ -387,7 +504,7 @@ namespace osmium {
                 for (auto it = range.first; it != range.second; ++it) {
                     MemberMeta& member_meta = *it;
                     if (member_meta.removed()) {
-                        break;
+                        continue;
                     }
                     assert(member_meta.member_id() == object.id());
                     assert(member_meta.relation_pos() < m_relations.size());
@@ -405,10 +522,13 @@ namespace osmium {
                     }
                 }
 
-                // Remove MemberMetas that were marked as removed.
-                mmv.erase(std::remove_if(mmv.begin(), mmv.end(), [](MemberMeta& mm) {
-                    return mm.removed();
-                }), mmv.end());
+                // This can't be done in possibly_purge_removed_members()
+                // directly, because it would invalidate the iterators in
+                // the loop above.
+                if (m_must_erase_removed_member_metas) {
+                    erase_removed_member_metas();
+                    m_must_erase_removed_member_metas = false;
+                }
 
                 return true;
             }
@@ -424,11 +544,13 @@ namespace osmium {
                         // if this is the last time this object was needed
                         // then mark it as removed
                         if (osmium::relations::count_not_removed(range.first, range.second) == 1) {
-                            get_member(range.first->buffer_offset()).set_removed(true);
+                            osmium::OSMObject& object = get_member(range.first->buffer_offset());
+                            object.set_removed(true);
+                            m_removed_members_size += object.padded_size();
                         }
 
                         for (auto it = range.first; it != range.second; ++it) {
-                            if (!it->removed() && relation.id() == get_relation(it->relation_pos()).id()) {
+                            if (!it->removed() && m_relations[it->relation_pos()].relation_offset() == relation_meta.relation_offset()) {
                                 it->remove();
                                 break;
                             }
@@ -439,12 +561,19 @@ namespace osmium {
 
         public:
 
+            /**
+             * Print statistics about the memory used to stdout and return
+             * the number of bytes used in RAM. If the members buffer was
+             * moved to a temporary file, its size is not included.
+             */
             uint64_t used_memory() const {
                 const uint64_t nmembers = m_member_meta[0].capacity() + m_member_meta[1].capacity() + m_member_meta[2].capacity();
                 const uint64_t members = nmembers * sizeof(MemberMeta);
+                const uint64_t filters = m_member_filter[0].used_memory() + m_member_filter[1].used_memory() + m_member_filter[2].used_memory();
                 const uint64_t relations = m_relations.capacity() * sizeof(RelationMeta);
                 const uint64_t relations_buffer_capacity = m_relations_buffer.capacity();
-                const uint64_t members_buffer_capacity = m_members_buffer.capacity();
+                const uint64_t members_buffer_capacity = m_members_file ? 0 : m_members_buffer.capacity();
+                const uint64_t members_file_size = m_members_file ? m_members_buffer.capacity() : 0;
 
                 std::cout << "  nR  = m_relations.capacity() ........... = " << std::setw(12) << m_relations.capacity() << "\n";
                 std::cout << "  nMN = m_member_meta[NODE].capacity() ... = " << std::setw(12) << m_member_meta[0].capacity() << "\n";
@@ -459,13 +588,49 @@ namespace osmium {
                 std::cout << "  nM * sMM ............................... = " << std::setw(12) << members << "\n";
                 std::cout << "  relations_buffer_capacity .............. = " << std::setw(12) << relations_buffer_capacity << "\n";
                 std::cout << "  members_buffer_capacity ................ = " << std::setw(12) << members_buffer_capacity << "\n";
+                std::cout << "  member filters ......................... = " << std::setw(12) << filters << "\n";
 
-                const uint64_t total = relations + members + relations_buffer_capacity + members_buffer_capacity;
+                const uint64_t total = relations + members + relations_buffer_capacity + members_buffer_capacity + filters;
 
                 std::cout << "  total .................................. = " << std::setw(12) << total << "\n";
                 std::cout << "  =======================================================\n";
+                std::cout << "  members_buffer_committed ............... = " << std::setw(12) << m_members_buffer.committed() << "\n";
+                std::cout << "  members_removed_not_purged ............. = " << std::setw(12) << m_removed_members_size << "\n";
+                std::cout << "  members_file_size ...................... = " << std::setw(12) << members_file_size << "\n";
+                std::cout << "  =======================================================\n";
+
+                return total;
+            }
+
+            /**
+             * Set the maximum number of bytes the member objects should
+             * use in RAM. If more are needed, the members buffer is moved
+             * to a temporary file which is memory mapped, so the operating
+             * system can write it out and read it back in as needed. The
+             * file is removed when the collector is destructed. Objects
+             * which are not needed any more are purged from the buffer
+             * more often once it is near the budget.
+             *
+             * The budget covers the memory allocated for the members
+             * buffer, not only the data in it. If the budget is smaller
+             * than the initial size of the buffer, the buffer is made
+             * smaller.
+             *
+             * Call this before the second pass. The default is no limit.
+             */
+            void set_members_memory_budget(size_t bytes) {
+                m_members_memory_budget = bytes;
+                const size_t capacity = std::max(bytes - bytes % osmium::memory::align_bytes, size_t(osmium::memory::align_bytes));
+                if (m_members_buffer.committed() == 0 && !m_members_file && capacity < m_members_buffer.capacity()) {
+                    m_members_buffer = osmium::memory::Buffer(capacity, osmium::memory::Buffer::auto_grow::yes);
+                }
+            }
 
-                return relations_buffer_capacity + members_buffer_capacity + relations + members;
+            /**
+             * Has the members buffer been moved to a temporary file?
+             */
+            bool members_on_disk() const noexcept {
+                return !!m_members_file;
             }
 
             /**
@@ -510,26 +675,49 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Remove MemberMetas that were marked as removed from the
+             * member vectors.
+             *
+             * They are not removed immediately when a relation is
+             * complete, because that would mean going through the whole
+             * vector every time. Until they are removed here, they stay
+             * in place, so the vectors are still sorted, and they are
+             * skipped when looking for relations needing a member.
+             */
+            void erase_removed_member_metas() {
+                for (auto& mmv : m_member_meta) {
+                    mmv.erase(std::remove_if(mmv.begin(), mmv.end(), [](const MemberMeta& mm) {
+                        return mm.removed();
+                    }), mmv.end());
+                }
+            }
+
             /**
              * Decide whether to purge removed members and then do it.
              *
-             * Currently the purging is done every thousand calls.
-             * This could probably be improved upon.
+             * The members buffer is purged once at least half of it is
+             * taken up by removed objects, so that purging, which has to
+             * look at all objects, takes amortized constant time per
+             * object. If the members buffer can't double its capacity
+             * within the memory budget any more or is on disk, it is
+             * purged once an eighth of it is removed objects.
              */
             void possibly_purge_removed_members() {
                 ++m_count_complete;
-                if (m_count_complete > 10000) { // XXX
-//                    const size_t size_before = m_members_buffer.committed();
-                    m_members_buffer.purge_removed(this);
-/*
-                    const size_t size_after = m_members_buffer.committed();
-                    double percent = static_cast<double>(size_before - size_after);
-                    percent /= size_before;
-                    percent *= 100;
-                    std::cerr << "PURGE (size before=" << size_before << " after=" << size_after << " purged=" << (size_before - size_after) << " / " << static_cast<int>(percent) << "%)\n";
-*/
+                if (m_count_complete > 10000) {
+                    m_must_erase_removed_member_metas = true;
                     m_count_complete = 0;
                 }
+
+                // Near the budget the buffer can't double its capacity
+                // any more.
+                const size_t committed = m_members_buffer.committed();
+                const bool near_budget = m_members_file || m_members_buffer.capacity() > m_members_memory_budget / 2;
+                const size_t min_size = near_budget ? committed / 8 : committed / 2;
+                if (m_removed_members_size > 0 && m_removed_members_size >= min_size && m_removed_members_size >= min_purge_size) {
+                    purge_removed_members();
+                }
             }
 
             /**
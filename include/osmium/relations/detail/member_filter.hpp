@@ -0,0 +1,143 @@
+#ifndef OSMIUM_RELATIONS_DETAIL_MEMBER_FILTER_HPP
+#define OSMIUM_RELATIONS_DETAIL_MEMBER_FILTER_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <osmium/osm/types.hpp>
+
+namespace osmium {
+
+    namespace relations {
+
+        /**
+         * Helper class for the Collector class.
+         *
+         * A Bloom filter over the IDs of relation members. It answers the
+         * question "could this be a member?" with one memory access, so
+         * that most objects which are not members can be rejected without
+         * a binary search through the member list. It can return false
+         * positives, but no false negatives.
+         *
+         * Each ID sets two bits in one 64 bit word of the filter. With the
+         * filter size used here (at least 16 bits per ID) at most about two
+         * in a hundred non-members get through.
+         */
+        class MemberFilter {
+
+            std::vector<uint64_t> m_words;
+            uint64_t m_mask = 0;
+
+            // The MurmurHash3 finalizer mixes all bits well, so the word
+            // index can come from the low bits and the two bit positions
+            // from the top 12 bits. They don't overlap for any filter
+            // size below 2^52 words.
+            static uint64_t hash(osmium::object_id_type id) noexcept {
+                uint64_t h = static_cast<uint64_t>(id);
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdULL;
+                h ^= h >> 33;
+                h *= 0xc4ceb9fe1a85ec53ULL;
+                h ^= h >> 33;
+                return h;
+            }
+
+            uint64_t& word(uint64_t h) noexcept {
+                return m_words[h & m_mask];
+            }
+
+            const uint64_t& word(uint64_t h) const noexcept {
+                return m_words[h & m_mask];
+            }
+
+            static uint64_t bits(uint64_t h) noexcept {
+                return (uint64_t(1) << (h >> 58)) | (uint64_t(1) << ((h >> 52) & 63));
+            }
+
+        public:
+
+            MemberFilter() = default;
+
+            /**
+             * Clear the filter and size it for the given number of IDs.
+             * If it is 0, the filter doesn't let anything through.
+             */
+            void reset(size_t num_ids) {
+                m_words.clear();
+                m_mask = 0;
+                if (num_ids == 0) {
+                    return;
+                }
+                size_t num_words = 1;
+                while (num_words * 64 < num_ids * 16) {
+                    num_words *= 2;
+                }
+                m_words.resize(num_words);
+                m_mask = num_words - 1;
+            }
+
+            /**
+             * Add an ID to the filter. reset() must have been called with
+             * a non-zero number of IDs.
+             */
+            void add(osmium::object_id_type id) noexcept {
+                const uint64_t h = hash(id);
+                word(h) |= bits(h);
+            }
+
+            /**
+             * Could the ID have been added to the filter?
+             */
+            bool might_contain(osmium::object_id_type id) const noexcept {
+                if (m_words.empty()) {
+                    return false;
+                }
+                const uint64_t h = hash(id);
+                const uint64_t b = bits(h);
+                return (word(h) & b) == b;
+            }
+
+            size_t used_memory() const noexcept {
+                return m_words.capacity() * sizeof(uint64_t);
+            }
+
+        }; // class MemberFilter
+
+    } // namespace relations
+
+} // namespace osmium
+
+#endif // OSMIUM_RELATIONS_DETAIL_MEMBER_FILTER_HPP
@@ -0,0 +1,467 @@
+#ifndef OSMIUM_TAGS_COMPILED_FILTER_HPP
+#define OSMIUM_TAGS_COMPILED_FILTER_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/iterator/filter_iterator.hpp>
+
+#include <osmium/memory/collection.hpp>
+#include <osmium/osm/tag.hpp>
+
+namespace osmium {
+
+    namespace tags {
+
+        namespace detail {
+
+            // Rule index used if no rule matches.
+            constexpr const uint32_t no_rule = std::numeric_limits<uint32_t>::max();
+
+            /**
+             * A reference to a string (not necessarily null-terminated)
+             * used as key in the hash tables of the CompiledFilter.
+             */
+            struct string_ref {
+
+                const char* data;
+                size_t size;
+
+                string_ref(const char* d, size_t s) noexcept :
+                    data(d),
+                    size(s) {
+                }
+
+            }; // struct string_ref
+
+            inline bool operator==(const string_ref& lhs, const string_ref& rhs) noexcept {
+                return lhs.size == rhs.size && std::memcmp(lhs.data, rhs.data, lhs.size) == 0;
+            }
+
+            struct string_ref_hash {
+
+                // FNV-1a
+                size_t operator()(const string_ref& str) const noexcept {
+                    uint64_t hash = 14695981039346656037ULL;
+                    for (size_t i = 0; i < str.size; ++i) {
+                        hash ^= static_cast<unsigned char>(str.data[i]);
+                        hash *= 1099511628211ULL;
+                    }
+                    return static_cast<size_t>(hash);
+                }
+
+            }; // struct string_ref_hash
+
+        } // namespace detail
+
+        /**
+         * A tag filter with the same first-match semantics as the Filter
+         * class: The rules are checked in the order they were added and
+         * the result of the first matching rule is returned. If no rule
+         * matches, the default result is returned.
+         *
+         * Unlike the Filter class, which compares each tag to every rule,
+         * the rules are compiled into hash tables when they are added:
+         * One table for the keys and one for key prefixes, each with the
+         * value rules for this key in a further hash table. So checking a
+         * tag only needs a few hash lookups, however many rules there are.
+         *
+         * Rules can match a key (like the KeyFilter), a key and a value
+         * (like the KeyValueFilter), or a key prefix (like the
+         * KeyPrefixFilter), optionally with a value.
+         *
+         * Use the StringTableMatcher if the tags are available as indexes
+         * into a string table, as in PBF files.
+         */
+        class CompiledFilter {
+
+            // Index and result of the first rule matching.
+            struct rule_match {
+
+                uint32_t index = detail::no_rule;
+                bool result = false;
+
+                void update(const rule_match& other) noexcept {
+                    if (other.index < index) {
+                        *this = other;
+                    }
+                }
+
+            }; // struct rule_match
+
+            // The rules for one key or key prefix.
+            struct key_rules {
+
+                // The first rule matching any value.
+                rule_match any_value;
+
+                // The first rule for each value (by value id).
+                std::unordered_map<uint32_t, rule_match> values;
+
+            }; // struct key_rules
+
+            // A rule as it was added.
+            struct rule {
+
+                std::string key;
+                std::string value;
+                bool result;
+                bool prefix;
+                bool has_value;
+
+            }; // struct rule
+
+            typedef std::unordered_map<detail::string_ref, uint32_t, detail::string_ref_hash> string_map_type;
+
+            // All rules in the order they were added. The hash tables
+            // reference the key and value strings in here. A deque doesn't
+            // move its elements, so the references stay valid.
+            std::deque<rule> m_rules;
+
+            // Maps key strings to index in m_key_rules.
+            string_map_type m_keys;
+
+            // Maps key prefix strings to index in m_key_rules.
+            string_map_type m_prefixes;
+
+            // Lengths of all prefixes in m_prefixes in ascending order.
+            std::vector<size_t> m_prefix_lengths;
+
+            // Maps value strings used in any rule to a value id.
+            string_map_type m_values;
+
+            std::deque<key_rules> m_key_rules;
+
+            bool m_default_result;
+
+            key_rules& get_key_rules(string_map_type& map, const std::string& key) {
+                const auto result = map.emplace(detail::string_ref{key.data(), key.size()}, static_cast<uint32_t>(m_key_rules.size()));
+                if (result.second) {
+                    m_key_rules.emplace_back();
+                }
+                return m_key_rules[result.first->second];
+            }
+
+            uint32_t get_value_id(const std::string& value) {
+                const auto result = m_values.emplace(detail::string_ref{value.data(), value.size()}, static_cast<uint32_t>(m_values.size()));
+                return result.first->second;
+            }
+
+            void add_prefix_length(size_t length) {
+                const auto it = std::lower_bound(m_prefix_lengths.begin(), m_prefix_lengths.end(), length);
+                if (it == m_prefix_lengths.end() || *it != length) {
+                    m_prefix_lengths.insert(it, length);
+                }
+            }
+
+            // Add rule to the hash tables. It must already be in m_rules.
+            void compile(const rule& r) {
+                rule_match match;
+                match.index = static_cast<uint32_t>(m_rules.size() - 1);
+                match.result = r.result;
+
+                key_rules& rules = get_key_rules(r.prefix ? m_prefixes : m_keys, r.key);
+                if (r.has_value) {
+                    // emplace() doesn't overwrite an earlier rule for the same value
+                    rules.values.emplace(get_value_id(r.value), match);
+                } else {
+                    rules.any_value.update(match);
+                }
+
+                if (r.prefix) {
+                    add_prefix_length(r.key.size());
+                }
+            }
+
+            CompiledFilter& add_rule(bool result, bool prefix, const std::string& key, const std::string* value) {
+                m_rules.push_back(rule{key, value ? *value : std::string{}, result, prefix, value != nullptr});
+                compile(m_rules.back());
+                return *this;
+            }
+
+            uint32_t find_value_id(const char* value) const {
+                const auto it = m_values.find(detail::string_ref{value, std::strlen(value)});
+                return it == m_values.end() ? detail::no_rule : it->second;
+            }
+
+            static void check_value(const key_rules& rules, uint32_t value_id, rule_match& match) {
+                if (value_id != detail::no_rule) {
+                    const auto it = rules.values.find(value_id);
+                    if (it != rules.values.end()) {
+                        match.update(it->second);
+                    }
+                }
+            }
+
+            /**
+             * Call func with the key_rules of all rules matching the key
+             * exactly or with a prefix.
+             */
+            template <typename TFunc>
+            void for_each_key_rules(const char* key, TFunc&& func) const {
+                const size_t key_length = std::strlen(key);
+
+                const auto it = m_keys.find(detail::string_ref{key, key_length});
+                if (it != m_keys.end()) {
+                    func(m_key_rules[it->second]);
+                }
+
+                for (const size_t prefix_length : m_prefix_lengths) {
+                    if (prefix_length > key_length) {
+                        break;
+                    }
+                    const auto pit = m_prefixes.find(detail::string_ref{key, prefix_length});
+                    if (pit != m_prefixes.end()) {
+                        func(m_key_rules[pit->second]);
+                    }
+                }
+            }
+
+            bool result(const rule_match& match) const noexcept {
+                return match.index == detail::no_rule ? m_default_result : match.result;
+            }
+
+        public:
+
+            typedef const osmium::Tag& argument_type;
+            typedef bool result_type;
+            typedef boost::filter_iterator<CompiledFilter, osmium::TagList::const_iterator> iterator;
+
+            class StringTableMatcher;
+
+            explicit CompiledFilter(bool default_result = false) :
+                m_default_result(default_result) {
+            }
+
+            /**
+             * Copying a filter compiles all rules again, so filters
+             * should be passed by reference where possible.
+             */
+            CompiledFilter(const CompiledFilter& other) :
+                m_default_result(other.m_default_result) {
+                for (const rule& r : other.m_rules) {
+                    m_rules.push_back(r);
+                    compile(m_rules.back());
+                }
+            }
+
+            CompiledFilter& operator=(const CompiledFilter& other) {
+                CompiledFilter copy(other);
+                *this = std::move(copy);
+                return *this;
+            }
+
+            // Moving keeps the strings in m_rules where they are, so the
+            // hash tables stay valid.
+            CompiledFilter(CompiledFilter&&) = default;
+            CompiledFilter& operator=(CompiledFilter&&) = default;
+
+            ~CompiledFilter() = default;
+
+            /**
+             * Add a rule matching all tags with the given key.
+             */
+            CompiledFilter& add(bool result, const std::string& key) {
+                return add_rule(result, false, key, nullptr);
+            }
+
+            /**
+             * Add a rule matching all tags with the given key and value.
+             */
+            CompiledFilter& add(bool result, const std::string& key, const std::string& value) {
+                return add_rule(result, false, key, &value);
+            }
+
+            /**
+             * Add a rule matching all tags with a key starting with the
+             * given prefix.
+             */
+            CompiledFilter& add_prefix(bool result, const std::string& key_prefix) {
+                return add_rule(result, true, key_prefix, nullptr);
+            }
+
+            /**
+             * Add a rule matching all tags with a key starting with the
+             * given prefix and the given value.
+             */
+            CompiledFilter& add_prefix(bool result, const std::string& key_prefix, const std::string& value) {
+                return add_rule(result, true, key_prefix, &value);
+            }
+
+            /**
+             * Check a tag given as key and value against the rules.
+             */
+            bool operator()(const char* key, const char* value) const {
+                rule_match match;
+                uint32_t value_id = detail::no_rule;
+                bool value_looked_up = false;
+
+                for_each_key_rules(key, [&](const key_rules& rules) {
+                    match.update(rules.any_value);
+                    if (!rules.values.empty()) {
+                        if (!value_looked_up) {
+                            value_id = find_value_id(value);
+                            value_looked_up = true;
+                        }
+                        check_value(rules, value_id, match);
+                    }
+                });
+
+                return result(match);
+            }
+
+            bool operator()(const osmium::Tag& tag) const {
+                return (*this)(tag.key(), tag.value());
+            }
+
+            /**
+             * Return the number of rules in this filter.
+             */
+            size_t count() const noexcept {
+                return m_rules.size();
+            }
+
+            /**
+             * Is this filter empty, ie are there no rules defined?
+             */
+            bool empty() const noexcept {
+                return m_rules.empty();
+            }
+
+        }; // class CompiledFilter
+
+        /**
+         * Checks tags given as indexes into a string table, such as the
+         * one of a PBF PrimitiveBlock, against the rules of a
+         * CompiledFilter. All strings in the table are looked up in the
+         * filter once when the matcher is created, after that checking a
+         * tag only needs array lookups and, if there are rules with values
+         * for the key, a lookup of the value id.
+         *
+         * The filter must not be changed or destroyed while the matcher
+         * is used.
+         */
+        class CompiledFilter::StringTableMatcher {
+
+            // Information about one string of the table used as key.
+            struct key_info {
+
+                // The first rule matching the key with any value.
+                rule_match any_value;
+
+                // Range in m_value_rules with the rules for this key
+                // that need a value.
+                uint32_t value_rules_begin;
+                uint32_t value_rules_end;
+
+            }; // struct key_info
+
+            const CompiledFilter* m_filter;
+            std::vector<key_info> m_keys;
+            std::vector<uint32_t> m_value_ids;
+            std::vector<const key_rules*> m_value_rules;
+
+            static const char* c_str(const char* str) noexcept {
+                return str;
+            }
+
+            static const char* c_str(const std::string& str) noexcept {
+                return str.c_str();
+            }
+
+        public:
+
+            /**
+             * Create matcher for the string table in the range [begin,
+             * end). The elements of the table can be "const char*" or
+             * std::string.
+             */
+            template <typename TIterator>
+            StringTableMatcher(const CompiledFilter& filter, TIterator begin, TIterator end) :
+                m_filter(&filter),
+                m_keys(),
+                m_value_ids(),
+                m_value_rules() {
+                for (; begin != end; ++begin) {
+                    const char* str = c_str(*begin);
+                    key_info info;
+                    info.value_rules_begin = static_cast<uint32_t>(m_value_rules.size());
+                    filter.for_each_key_rules(str, [&](const key_rules& rules) {
+                        info.any_value.update(rules.any_value);
+                        if (!rules.values.empty()) {
+                            m_value_rules.push_back(&rules);
+                        }
+                    });
+                    info.value_rules_end = static_cast<uint32_t>(m_value_rules.size());
+                    m_keys.push_back(info);
+                    m_value_ids.push_back(filter.m_values.empty() ? detail::no_rule : filter.find_value_id(str));
+                }
+            }
+
+            /**
+             * Check a tag given as indexes of its key and value in the
+             * string table.
+             */
+            bool operator()(size_t key_index, size_t value_index) const {
+                const key_info& info = m_keys[key_index];
+                rule_match match = info.any_value;
+                for (auto i = info.value_rules_begin; i != info.value_rules_end; ++i) {
+                    check_value(*m_value_rules[i], m_value_ids[value_index], match);
+                }
+                return m_filter->result(match);
+            }
+
+            /**
+             * Number of strings in the string table.
+             */
+            size_t size() const noexcept {
+                return m_keys.size();
+            }
+
+        }; // class CompiledFilter::StringTableMatcher
+
+    } // namespace tags
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_COMPILED_FILTER_HPP
@@ -179,6 +179,23 @@ namespace osmium {
                 m_work_queue.shutdown();
             }
 
+            int num_threads() const noexcept {
+                return m_num_threads;
+            }
+
+            /**
+             * Is the calling thread one of the worker threads of this pool?
+             * Code running in a task can use this to avoid waiting for
+             * other tasks on the same pool, which deadlocks if all workers
+             * are waiting.
+             */
+            bool is_worker_thread() const noexcept {
+                const auto id = std::this_thread::get_id();
+                return std::any_of(m_threads.begin(), m_threads.end(), [id](const std::thread& thread) {
+                    return thread.get_id() == id;
+                });
+            }
+
             size_t queue_size() const {
                 return m_work_queue.size();
             }
@@ -50,4 +50,11 @@ DEALINGS IN THE SOFTWARE.
 # define OSMIUM_DEPRECATED
 #endif
 
+// Hint to the CPU that the memory at addr will be read soon
+#ifdef __GNUC__
+# define OSMIUM_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+# define OSMIUM_PREFETCH(addr)
+#endif
+
 #endif // OSMIUM_UTIL_COMPATIBILITY_HPP
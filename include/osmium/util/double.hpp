@@ -36,10 +36,13 @@ DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <iterator>
 #include <string>
 
+#include <osmium/util/number_format.hpp>
+
 namespace osmium {
 
     namespace util {
@@ -59,6 +62,40 @@ namespace osmium {
         inline T double2string(T iterator, double value, int precision) {
             assert(precision <= 17);
 
+            static const double powers_of_ten[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17
+            };
+
+            // Fast path: If the value scaled by 10^precision is small
+            // enough, the rounding error of the scaling is below 0.001.
+            // If the scaled value isn't that close to halfway between two
+            // integers, it can be rounded and written as fixed-point
+            // number with integer arithmetic. This gives exactly the same
+            // result as snprintf(). Coordinates from Locations with
+            // precision 7 always take this path.
+            if (precision > 0) {
+                const double scaled = value * powers_of_ten[precision];
+                const double rounded = std::round(scaled);
+                if (std::abs(scaled) < 4.0e12 && std::abs(scaled - rounded) < 0.499) {
+                    char buffer[max_number_length];
+                    char* end = buffer + max_number_length;
+                    char* begin = detail::write_fixed_point_backwards(end, static_cast<uint64_t>(std::abs(rounded)), precision);
+                    if (std::signbit(value)) {
+                        *--begin = '-';
+                    }
+
+                    while (*(end - 1) == '0') {
+                        --end;
+                    }
+                    if (*(end - 1) == '.') {
+                        --end;
+                    }
+
+                    return std::copy(begin, end, iterator);
+                }
+            }
+
             char buffer[max_double_length];
 
 #ifndef _MSC_VER
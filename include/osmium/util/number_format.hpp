@@ -0,0 +1,168 @@
+#ifndef OSMIUM_UTIL_NUMBER_FORMAT_HPP
+#define OSMIUM_UTIL_NUMBER_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (http://osmcode.org/libosmium).
+
+Copyright 2013-2015 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace osmium {
+
+    namespace util {
+
+        /**
+         * Maximum number of characters needed for an integer of up to 64
+         * bits or a fixed-point number made from one (sign, 20 digits,
+         * decimal point, and leading zero).
+         */
+        constexpr int max_number_length = 24;
+
+        namespace detail {
+
+            /**
+             * Write the decimal digits of value into the buffer ending
+             * at end.
+             *
+             * @returns pointer to the first digit written.
+             */
+            inline char* write_uint_backwards(char* end, uint64_t value) noexcept {
+                do {
+                    *--end = static_cast<char>('0' + value % 10);
+                    value /= 10;
+                } while (value != 0);
+                return end;
+            }
+
+            /**
+             * Write value / 10^precision with exactly precision digits
+             * after the decimal point into the buffer ending at end. If
+             * precision is 0, no decimal point is written.
+             *
+             * @returns pointer to the first character written.
+             */
+            inline char* write_fixed_point_backwards(char* end, uint64_t value, int precision) noexcept {
+                for (int i = 0; i < precision; ++i) {
+                    *--end = static_cast<char>('0' + value % 10);
+                    value /= 10;
+                }
+                if (precision > 0) {
+                    *--end = '.';
+                }
+                return write_uint_backwards(end, value);
+            }
+
+            template <typename T>
+            inline uint64_t magnitude(T value, bool& negative, std::true_type /*is_signed*/) noexcept {
+                negative = value < 0;
+                return negative ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+            }
+
+            template <typename T>
+            inline uint64_t magnitude(T value, bool& negative, std::false_type /*is_signed*/) noexcept {
+                negative = false;
+                return static_cast<uint64_t>(value);
+            }
+
+        } // namespace detail
+
+        /**
+         * Append the decimal representation of an integer to a string.
+         * Same output as the printf formats "%d", "%*d", and "%0*d", but
+         * much faster.
+         *
+         * @tparam T integer type
+         * @param out string
+         * @param value the value that should be written
+         * @param width minimum number of characters written
+         * @param fill character used to fill up to width, if this is '0'
+         *             the zeros are added after the sign
+         */
+        template <typename T>
+        inline void append_int(std::string& out, T value, int width = 0, char fill = ' ') {
+            static_assert(std::is_integral<T>::value, "append_int() needs an integer type");
+            char buffer[max_number_length];
+            char* const end = buffer + max_number_length;
+
+            bool negative;
+            char* begin = detail::write_uint_backwards(end, detail::magnitude(value, negative, std::is_signed<T>()));
+
+            const auto len = (end - begin) + (negative ? 1 : 0);
+            const auto padding = len < width ? static_cast<std::string::size_type>(width - len) : 0;
+            if (fill == '0') {
+                if (negative) {
+                    out += '-';
+                }
+                out.append(padding, '0');
+            } else {
+                out.append(padding, fill);
+                if (negative) {
+                    out += '-';
+                }
+            }
+            out.append(begin, end);
+        }
+
+        /**
+         * Append the fixed-point number value / 10^precision to a string
+         * with exactly precision digits after the decimal point. This is
+         * the same as printf("%.*f", precision, value / 10^precision)
+         * would output, but it only uses integer arithmetic, so it is
+         * fast, exact and doesn't depend on the locale.
+         *
+         * This is used to write coordinates of Locations, which are stored
+         * as fixed-point numbers with a precision of 7.
+         *
+         * @param out string
+         * @param value the value that should be written
+         * @param precision number of digits after the decimal point (must be <= 19)
+         */
+        inline void append_fixed_point(std::string& out, int64_t value, int precision) {
+            assert(precision >= 0 && precision <= 19);
+            char buffer[max_number_length];
+            char* const end = buffer + max_number_length;
+
+            bool negative;
+            char* begin = detail::write_fixed_point_backwards(end, detail::magnitude(value, negative, std::true_type()), precision);
+            if (negative) {
+                *--begin = '-';
+            }
+            out.append(begin, end);
+        }
+
+    } // namespace util
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_NUMBER_FORMAT_HPP
@@ -0,0 +1,154 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_collector.hpp>
+#include <osmium/area/problem_reporter_stream.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/visitor.hpp>
+
+#include "../basic/helper.hpp"
+
+typedef std::vector<std::pair<osmium::object_id_type, osmium::Location>> node_list;
+
+static node_list square(osmium::object_id_type first_id, int32_t x, int32_t y, int32_t size) {
+    return {
+        {first_id,     osmium::Location{x,        y}},
+        {first_id + 1, osmium::Location{x + size, y}},
+        {first_id + 2, osmium::Location{x + size, y + size}},
+        {first_id + 3, osmium::Location{x,        y + size}},
+        {first_id,     osmium::Location{x,        y}}
+    };
+}
+
+// Relations with an outer ring made of two ways and an inner ring, and
+// closed ways tagged as areas in between.
+static void fill_buffers(osmium::memory::Buffer& relations, osmium::memory::Buffer& ways) {
+    osmium::object_id_type node_id = 1;
+    for (osmium::object_id_type n = 1; n <= 500; ++n) {
+        const int32_t x = static_cast<int32_t>(n) * 1000;
+        const node_list outer = square(node_id, x, 0, 100);
+        node_id += 4;
+        const node_list inner = square(node_id, x + 10, 10, 50);
+        node_id += 4;
+
+        buffer_add_way(ways, "", {}, node_list(outer.begin(), outer.begin() + 3)).set_id(3 * n);
+        buffer_add_way(ways, "", {}, node_list(outer.begin() + 2, outer.end())).set_id(3 * n + 1);
+        buffer_add_way(ways, "", {}, inner).set_id(3 * n + 2);
+        buffer_add_relation(relations, "", {{"type", "multipolygon"}, {"landuse", "forest"}}, {
+            std::make_tuple('w', 3 * n, "outer"),
+            std::make_tuple('w', 3 * n + 1, "outer"),
+            std::make_tuple('w', 3 * n + 2, "inner")
+        }).set_id(n);
+
+        buffer_add_way(ways, "", {{"building", "yes"}}, square(node_id, x, 500, 100)).set_id(3 * n + 100000);
+        node_id += 4;
+    }
+}
+
+static std::string assemble(bool use_pool_threads, bool deterministic) {
+    osmium::memory::Buffer relations(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    osmium::memory::Buffer ways(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    fill_buffers(relations, ways);
+
+    osmium::area::AssemblerConfig config;
+    osmium::area::MultipolygonCollector<osmium::area::Assembler> collector(config);
+    if (use_pool_threads) {
+        collector.use_pool_threads(deterministic);
+    }
+    collector.read_relations(relations.begin(), relations.end());
+
+    std::string result;
+    osmium::apply(ways, collector.handler([&result](osmium::memory::Buffer&& buffer) {
+        result.append(reinterpret_cast<const char*>(buffer.data()), buffer.committed());
+    }));
+    return result;
+}
+
+static std::vector<osmium::object_id_type> area_ids(const std::string& data) {
+    osmium::memory::Buffer buffer(reinterpret_cast<unsigned char*>(const_cast<char*>(data.data())), data.size());
+    std::vector<osmium::object_id_type> ids;
+    for (auto it = buffer.begin<osmium::Area>(); it != buffer.end<osmium::Area>(); ++it) {
+        ids.push_back(it->id());
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+TEST_CASE("Assemble areas on the thread pool") {
+
+    const std::string expected = assemble(false, true);
+    REQUIRE(area_ids(expected).size() == 1000);
+
+    SECTION("deterministic") {
+        REQUIRE(assemble(true, true) == expected);
+    }
+
+    SECTION("not deterministic") {
+        REQUIRE(area_ids(assemble(true, false)) == area_ids(expected));
+    }
+
+}
+
+TEST_CASE("Assembling areas on the thread pool needs config without problem reporter") {
+    std::ostringstream out;
+    osmium::area::ProblemReporterStream reporter(out);
+    osmium::area::AssemblerConfig config(&reporter);
+    osmium::area::MultipolygonCollector<osmium::area::Assembler> collector(config);
+
+    REQUIRE_THROWS_AS(collector.use_pool_threads(), std::invalid_argument);
+    REQUIRE_THROWS_AS(collector.use_pool_threads(false), std::invalid_argument);
+}
+
+TEST_CASE("Reuse assembler for several objects") {
+    osmium::memory::Buffer in_buffer(10240, osmium::memory::Buffer::auto_grow::yes);
+    osmium::memory::Buffer out_buffer(10240, osmium::memory::Buffer::auto_grow::yes);
+
+    buffer_add_way(in_buffer, "", {{"building", "yes"}}, square(1, 0, 0, 100));
+    const size_t bowtie_offset = in_buffer.commit();
+    buffer_add_way(in_buffer, "", {{"building", "yes"}}, {
+        {10, osmium::Location{0, 0}},
+        {11, osmium::Location{100, 100}},
+        {12, osmium::Location{100, 0}},
+        {13, osmium::Location{0, 100}},
+        {10, osmium::Location{0, 0}}
+    });
+    const size_t outer_offset = in_buffer.commit();
+    buffer_add_way(in_buffer, "", {}, square(20, 0, 0, 1000));
+    const size_t inner_offset = in_buffer.commit();
+    buffer_add_way(in_buffer, "", {}, square(30, 10, 10, 100));
+    in_buffer.commit();
+    const size_t relation_offset = in_buffer.committed();
+    buffer_add_relation(in_buffer, "", {{"type", "multipolygon"}, {"landuse", "forest"}}, {
+        std::make_tuple('w', 2, "outer"),
+        std::make_tuple('w', 3, "inner")
+    });
+    in_buffer.commit();
+
+    osmium::area::AssemblerConfig config;
+    osmium::area::Assembler assembler(config);
+
+    const osmium::Way& building = in_buffer.get<osmium::Way>(0);
+    assembler(building, out_buffer);
+    assembler(in_buffer.get<osmium::Way>(bowtie_offset), out_buffer);
+    assembler(in_buffer.get<osmium::Relation>(relation_offset), {outer_offset, inner_offset}, in_buffer, out_buffer);
+    assembler(building, out_buffer);
+
+    auto it = out_buffer.begin<osmium::Area>();
+    for (int n : {0, 3}) {
+        const osmium::Area& area = *std::next(it, n);
+        REQUIRE(area.num_rings() == std::make_pair(1, 0));
+        const osmium::OuterRing& ring = *area.cbegin<osmium::OuterRing>();
+        REQUIRE(ring.size() == building.nodes().size());
+        REQUIRE(std::equal(ring.cbegin(), ring.cend(), building.nodes().cbegin()));
+    }
+    REQUIRE(std::next(it, 1)->num_rings() == std::make_pair(0, 0));
+    REQUIRE(std::next(it, 2)->num_rings() == std::make_pair(1, 1));
+    REQUIRE(std::next(it, 4) == out_buffer.end<osmium::Area>());
+}
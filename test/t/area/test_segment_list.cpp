@@ -0,0 +1,167 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+
+using osmium::area::detail::NodeRefSegment;
+using osmium::area::detail::SegmentList;
+
+typedef std::tuple<osmium::Location, osmium::Location, osmium::Location> intersection_type;
+
+struct IntersectionRecorder : public osmium::area::ProblemReporter {
+
+    std::vector<intersection_type> intersections;
+
+    void report_intersection(osmium::object_id_type, osmium::Location way1_seg_start, osmium::Location,
+                             osmium::object_id_type, osmium::Location way2_seg_start, osmium::Location, osmium::Location intersection) override {
+        intersections.emplace_back(way1_seg_start, way2_seg_start, intersection);
+    }
+
+};
+
+static const osmium::Way& add_way(osmium::memory::Buffer& buffer, const std::vector<osmium::Location>& locations) {
+    {
+        osmium::builder::WayBuilder builder(buffer);
+        builder.add_user("");
+        osmium::builder::WayNodeListBuilder wnl_builder(buffer, &builder);
+        osmium::object_id_type ref = 1;
+        for (const auto& location : locations) {
+            wnl_builder.add_node_ref(ref++, location);
+        }
+    }
+    return buffer.get<const osmium::Way>(buffer.commit());
+}
+
+// All intersections in the order the pairwise check finds them.
+static std::vector<intersection_type> expected_intersections(const SegmentList& segments) {
+    std::vector<intersection_type> result;
+    for (auto it1 = segments.begin(); it1 != segments.end(); ++it1) {
+        for (auto it2 = std::next(it1); it2 != segments.end(); ++it2) {
+            if (y_range_overlap(*it1, *it2) && !outside_x_range(*it2, *it1)) {
+                const osmium::Location intersection = calculate_intersection(*it1, *it2);
+                if (intersection) {
+                    result.emplace_back(it1->first().location(), it2->first().location(), intersection);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+TEST_CASE("Find intersections in segment list") {
+
+    osmium::memory::Buffer buffer(10240, osmium::memory::Buffer::auto_grow::yes);
+    SegmentList segments(false);
+    IntersectionRecorder recorder;
+
+    SECTION("few segments") {
+        const osmium::Way& way = add_way(buffer, {
+            osmium::Location{0.0, 0.0},
+            osmium::Location{2.0, 2.0},
+            osmium::Location{2.0, 0.0},
+            osmium::Location{0.0, 2.0}
+        });
+        segments.extract_segments_from_way(way, "outer");
+        segments.sort();
+        segments.erase_duplicate_segments();
+
+        REQUIRE(segments.find_intersections(&recorder));
+        REQUIRE(recorder.intersections.size() == 1);
+        REQUIRE(std::get<2>(recorder.intersections[0]) == osmium::Location(1.0, 1.0));
+    }
+
+    SECTION("many segments") {
+        std::mt19937 gen(17);
+        std::uniform_int_distribution<int32_t> dx(0, 1000);
+        std::uniform_int_distribution<int32_t> dy(0, 50);
+
+        std::vector<osmium::Location> locations;
+        for (int32_t i = 0; i < 1000; ++i) {
+            locations.emplace_back(dx(gen), i * 10 + dy(gen));
+        }
+        const osmium::Way& way1 = add_way(buffer, locations);
+
+        locations.clear();
+        for (int32_t i = 0; i < 100; ++i) {
+            locations.emplace_back(i * 10, 5000 + dy(gen));
+        }
+        const osmium::Way& way2 = add_way(buffer, locations);
+
+        segments.extract_segments_from_way(way1, "outer");
+        segments.extract_segments_from_way(way2, "outer");
+        segments.sort();
+        segments.erase_duplicate_segments();
+
+        const auto expected = expected_intersections(segments);
+        REQUIRE(expected.size() > 100);
+
+        REQUIRE(segments.find_intersections(&recorder));
+        REQUIRE(recorder.intersections == expected);
+    }
+
+    SECTION("many segments without intersections") {
+        std::vector<osmium::Location> locations;
+        for (int32_t i = 0; i < 1000; ++i) {
+            locations.emplace_back(i % 2 * 10, i * 10);
+        }
+        const osmium::Way& way = add_way(buffer, locations);
+        segments.extract_segments_from_way(way, "outer");
+        segments.sort();
+        segments.erase_duplicate_segments();
+
+        REQUIRE_FALSE(segments.find_intersections(&recorder));
+        REQUIRE(recorder.intersections.empty());
+    }
+
+}
+
+
+TEST_CASE("Find segments left of location in segment list") {
+
+    osmium::memory::Buffer buffer(10240, osmium::memory::Buffer::auto_grow::yes);
+    SegmentList segments(false);
+
+    std::mt19937 gen(23);
+    std::uniform_int_distribution<int32_t> dist(0, 1000);
+
+    std::vector<osmium::Location> locations;
+    for (int i = 0; i < 500; ++i) {
+        locations.emplace_back(dist(gen), dist(gen));
+    }
+    const osmium::Way& way = add_way(buffer, locations);
+    segments.extract_segments_from_way(way, "outer");
+    segments.sort();
+    segments.erase_duplicate_segments();
+    segments.build_y_index();
+
+    for (const auto& location : locations) {
+        std::vector<const NodeRefSegment*> expected;
+        for (const auto& segment : segments) {
+            const std::pair<int32_t, int32_t> mm = std::minmax(segment.first().location().y(), segment.second().location().y());
+            if (segment.first().location().x() <= location.x() && mm.first <= location.y() && location.y() <= mm.second) {
+                expected.push_back(&segment);
+            }
+        }
+
+        std::vector<const NodeRefSegment*> found;
+        segments.for_each_segment_left_of(location, [&found](const NodeRefSegment& segment) {
+            found.push_back(&segment);
+        });
+        std::sort(found.begin(), found.end());
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(found == expected);
+    }
+
+    int count = 0;
+    segments.for_each_segment_left_of(osmium::Location{1000, 2000}, [&count](const NodeRefSegment&) {
+        ++count;
+    });
+    REQUIRE(count == 0);
+}
@@ -2,6 +2,7 @@
 
 #include <sstream>
 #include <type_traits>
+#include <unordered_set>
 
 #include <osmium/osm/location.hpp>
 
@@ -150,5 +151,14 @@ TEST_CASE("Location") {
         REQUIRE(out.str() == "(undefined,undefined)");
     }
 
-}
+    SECTION("hash") {
+        std::unordered_set<osmium::Location> locations;
+        locations.insert(osmium::Location{1.2, 3.4});
+        locations.insert(osmium::Location{3.4, 1.2});
+        locations.insert(osmium::Location{1.2, 3.4});
+        REQUIRE(locations.size() == 2);
+        REQUIRE(locations.count(osmium::Location{3.4, 1.2}) == 1);
+        REQUIRE(locations.count(osmium::Location{1.2, 1.2}) == 0);
+    }
 
+}
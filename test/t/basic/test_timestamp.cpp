@@ -42,6 +42,31 @@ TEST_CASE("Timestamp") {
 
     SECTION("throws if initialized from bad string") {
         REQUIRE_THROWS_AS(osmium::Timestamp("x"), std::invalid_argument);
+        REQUIRE_THROWS_AS(osmium::Timestamp(""), std::invalid_argument);
+        REQUIRE_THROWS_AS(osmium::Timestamp("2000-01-01"), std::invalid_argument);
+        REQUIRE_THROWS_AS(osmium::Timestamp("2000-01-01 00:00:00Z"), std::invalid_argument);
+        REQUIRE_THROWS_AS(osmium::Timestamp("2000-13-01T00:00:00Z"), std::invalid_argument);
+        REQUIRE_THROWS_AS(osmium::Timestamp("2001-02-29T00:00:00Z"), std::invalid_argument);
+        REQUIRE_THROWS_AS(osmium::Timestamp("2000-01-01T24:00:00Z"), std::invalid_argument);
+    }
+
+    SECTION("can be initialized from string with leap day") {
+        osmium::Timestamp t("2012-02-29T23:59:59Z");
+        REQUIRE(1330559999 == uint32_t(t));
+        REQUIRE("2012-02-29T23:59:59Z" == t.to_iso());
+    }
+
+    SECTION("can be appended to string") {
+        std::string s = "t=";
+        osmium::Timestamp(1330559999).to_iso_str(s);
+        REQUIRE("t=2012-02-29T23:59:59Z" == s);
+
+        osmium::Timestamp().to_iso_str(s);
+        REQUIRE("t=2012-02-29T23:59:59Z" == s);
+    }
+
+    SECTION("last possible timestamp") {
+        REQUIRE("2106-02-07T06:28:15Z" == osmium::end_of_time().to_iso());
     }
 
     SECTION("can be explicitly cast to time_t") {
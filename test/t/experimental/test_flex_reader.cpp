@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include <string>
+
+#include <osmium/experimental/flex_reader.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/xml_input.hpp>
+
+typedef osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
+typedef osmium::handler::NodeLocationsForWays<index_type> location_handler_type;
+
+static const std::string data =
+    "<?xml version='1.0' encoding='UTF-8'?>\n"
+    "<osm version='0.6' generator='testdata'>\n"
+    "  <node id='1' version='1' lon='1.0' lat='1.0'/>\n"
+    "  <node id='2' version='1' lon='2.0' lat='1.0'/>\n"
+    "  <node id='3' version='1' lon='2.0' lat='2.0'/>\n"
+    "  <node id='4' version='1' lon='1.0' lat='2.0'/>\n"
+    "  <node id='5' version='1' lon='3.0' lat='1.0'/>\n"
+    "  <node id='6' version='1' lon='4.0' lat='1.0'/>\n"
+    "  <node id='7' version='1' lon='4.0' lat='2.0'/>\n"
+    "  <way id='10' version='1'><nd ref='1'/><nd ref='2'/><nd ref='3'/><nd ref='4'/><nd ref='1'/><tag k='building' v='yes'/></way>\n"
+    "  <way id='11' version='1'><nd ref='5'/><nd ref='6'/><nd ref='7'/></way>\n"
+    "  <way id='12' version='1'><nd ref='7'/><nd ref='5'/></way>\n"
+    "  <relation id='20' version='1'>\n"
+    "    <member type='way' ref='11' role='outer'/>\n"
+    "    <member type='way' ref='12' role='outer'/>\n"
+    "    <tag k='type' v='multipolygon'/>\n"
+    "    <tag k='landuse' v='forest'/>\n"
+    "  </relation>\n"
+    "</osm>\n";
+
+TEST_CASE("FlexReader") {
+
+    index_type index;
+    location_handler_type location_handler(index);
+
+    osmium::io::File file(data.data(), data.size(), "osm");
+
+    int nodes = 0;
+    int ways = 0;
+    int ways_with_locations = 0;
+    int relations = 0;
+    int areas = 0;
+
+    SECTION("with areas") {
+        osmium::experimental::FlexReader<location_handler_type> reader(file, location_handler, osmium::osm_entity_bits::object);
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& item : buffer) {
+                switch (item.type()) {
+                    case osmium::item_type::node:
+                        ++nodes;
+                        break;
+                    case osmium::item_type::way:
+                        ++ways;
+                        if (static_cast<const osmium::Way&>(item).nodes().front().location()) {
+                            ++ways_with_locations;
+                        }
+                        break;
+                    case osmium::item_type::relation:
+                        ++relations;
+                        break;
+                    case osmium::item_type::area:
+                        ++areas;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+        REQUIRE(reader.eof());
+        reader.close();
+
+        REQUIRE(nodes == 7);
+        REQUIRE(ways == 3);
+        REQUIRE(ways_with_locations == 3);
+        REQUIRE(relations == 1);
+        REQUIRE(areas == 2);
+    }
+
+    SECTION("closed early") {
+        osmium::experimental::FlexReader<location_handler_type> reader(file, location_handler, osmium::osm_entity_bits::object);
+        REQUIRE(reader.read());
+        reader.close();
+        REQUIRE(reader.eof());
+        REQUIRE_FALSE(reader.read());
+    }
+
+}
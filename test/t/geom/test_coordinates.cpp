@@ -0,0 +1,41 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <osmium/geom/coordinates.hpp>
+
+TEST_CASE("Coordinates") {
+
+    SECTION("valid") {
+        REQUIRE(osmium::geom::Coordinates(1.5, -2.5).valid());
+        REQUIRE(osmium::geom::Coordinates(-180.0, 90.0).valid());
+    }
+
+    SECTION("invalid if one of them is not finite") {
+        REQUIRE_FALSE(osmium::geom::Coordinates(HUGE_VAL, 1.0).valid());
+        REQUIRE_FALSE(osmium::geom::Coordinates(1.0, HUGE_VAL).valid());
+        REQUIRE_FALSE(osmium::geom::Coordinates(HUGE_VAL, HUGE_VAL).valid());
+        REQUIRE_FALSE(osmium::geom::Coordinates(-HUGE_VAL, 1.0).valid());
+        REQUIRE_FALSE(osmium::geom::Coordinates(1.0, std::numeric_limits<double>::quiet_NaN()).valid());
+    }
+
+    SECTION("array of coordinates is an array of x and y doubles") {
+        // The projection hands arrays of Coordinates to the proj library
+        // as x and y arrays with a point offset of 2.
+        std::vector<osmium::geom::Coordinates> coordinates;
+        coordinates.emplace_back(1.0, 2.0);
+        coordinates.emplace_back(3.0, 4.0);
+        coordinates.emplace_back(5.0, 6.0);
+
+        const double* x = &coordinates.front().x;
+        const double* y = &coordinates.front().y;
+        REQUIRE(y - x == 1);
+        for (size_t i = 0; i < coordinates.size(); ++i) {
+            REQUIRE(x + 2 * i == &coordinates[i].x);
+            REQUIRE(y + 2 * i == &coordinates[i].y);
+        }
+    }
+
+}
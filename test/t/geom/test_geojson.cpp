@@ -232,5 +232,45 @@ SECTION("area_2outer_2inner") {
     }
 }
 
+SECTION("into_buffer") {
+    std::string out;
+    osmium::geom::GeoJSONBufferFactory<> factory(out);
+
+    osmium::memory::Buffer buffer(10000);
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {3.2, 4.2}},
+        {2, {3.6, 4.9}}
+    });
+    const osmium::Area& area = buffer_add_area(buffer,
+        "foo",
+        {},
+        {
+            { true, {
+                {1, {3.2, 4.2}},
+                {2, {3.5, 4.7}},
+                {3, {3.6, 4.9}},
+                {1, {3.2, 4.2}}
+            }}
+        });
+
+    const osmium::geom::output_range point = factory.create_point(osmium::Location(3.2, 4.2));
+    out += '\n';
+    const osmium::geom::output_range linestring = factory.create_linestring(wnl);
+    out += '\n';
+    const osmium::geom::output_range multipolygon = factory.create_multipolygon(area);
+
+    const std::string point_json{"{\"type\":\"Point\",\"coordinates\":[3.2,4.2]}"};
+    const std::string linestring_json{"{\"type\":\"LineString\",\"coordinates\":[[3.2,4.2],[3.6,4.9]]}"};
+    const std::string multipolygon_json{"{\"type\":\"MultiPolygon\",\"coordinates\":[[[[3.2,4.2],[3.5,4.7],[3.6,4.9],[3.2,4.2]]]]}"};
+    REQUIRE(point_json + '\n' + linestring_json + '\n' + multipolygon_json == out);
+
+    REQUIRE(point.offset == 0);
+    REQUIRE(point.size == point_json.size());
+    REQUIRE(linestring.offset == point_json.size() + 1);
+    REQUIRE(linestring.size == linestring_json.size());
+    REQUIRE(multipolygon.offset == linestring.offset + linestring.size + 1);
+    REQUIRE(multipolygon.size == multipolygon_json.size());
+}
+
 }
 
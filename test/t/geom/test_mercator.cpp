@@ -1,5 +1,7 @@
 #include "catch.hpp"
 
+#include <vector>
+
 #include <osmium/geom/mercator_projection.hpp>
 
 TEST_CASE("Mercator") {
@@ -34,4 +36,21 @@ TEST_CASE("Mercator") {
         REQUIRE(osmium::geom::detail::y_to_lat(osmium::geom::detail::lon_to_x(180.0)) == Approx(osmium::geom::MERCATOR_MAX_LAT).epsilon(0.0000001));
     }
 
+    SECTION("project_many_locations") {
+        osmium::geom::MercatorProjection projection;
+        const std::vector<osmium::Location> locations = {
+            osmium::Location{17.839, -3.249},
+            osmium::Location{-89.2, 15.915},
+            osmium::Location{180.0, 85.0}
+        };
+        std::vector<osmium::geom::Coordinates> coordinates(locations.size(), osmium::geom::Coordinates{0.0, 0.0});
+        osmium::geom::project_locations(projection, locations.data(), locations.data() + locations.size(), coordinates.data());
+        for (size_t i = 0; i < locations.size(); ++i) {
+            REQUIRE(coordinates[i] == projection(locations[i]));
+        }
+
+        const std::vector<osmium::Location> invalid = { osmium::Location{1.0, 2.0}, osmium::Location{} };
+        REQUIRE_THROWS_AS(osmium::geom::project_locations(projection, invalid.data(), invalid.data() + invalid.size(), coordinates.data()), osmium::invalid_location);
+    }
+
 }
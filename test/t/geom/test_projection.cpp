@@ -1,6 +1,7 @@
 #include "catch.hpp"
 
 #include <random>
+#include <vector>
 
 #include <osmium/geom/factory.hpp>
 #include <osmium/geom/mercator_projection.hpp>
@@ -146,4 +147,46 @@ SECTION("compare_mercators") {
     }
 }
 
+SECTION("project_many_locations") {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> dis_x(-180.0, 180.0);
+    std::uniform_real_distribution<> dis_y(-85.0, 85.0);
+
+    std::vector<osmium::Location> locations;
+    for (int n = 0; n < 1000; ++n) {
+        locations.emplace_back(dis_x(gen), dis_y(gen));
+    }
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size(), osmium::geom::Coordinates{0.0, 0.0});
+
+    for (const char* proj_string : {"+init=epsg:3857", "+init=epsg:4326", "+proj=longlat +ellps=intl +towgs84=-87,-98,-121 +no_defs"}) {
+        osmium::geom::Projection projection(proj_string);
+        projection(locations.data(), locations.data() + locations.size(), coordinates.data());
+
+        for (size_t i = 0; i < locations.size(); ++i) {
+            const osmium::geom::Coordinates c = projection(locations[i]);
+            REQUIRE(coordinates[i].x == Approx(c.x));
+            REQUIRE(coordinates[i].y == Approx(c.y));
+        }
+    }
+}
+
+SECTION("transform_many_coordinates") {
+    const osmium::geom::CRS wgs84(4326);
+    const osmium::geom::CRS mercator(3857);
+
+    std::vector<osmium::geom::Coordinates> coordinates;
+    for (double x = -170.0; x < 180.0; x += 10.0) {
+        coordinates.emplace_back(osmium::geom::deg_to_rad(x), osmium::geom::deg_to_rad(x / 2.5));
+    }
+    const std::vector<osmium::geom::Coordinates> input = coordinates;
+
+    transform(wgs84, mercator, coordinates.data(), coordinates.size());
+
+    for (size_t i = 0; i < input.size(); ++i) {
+        const osmium::geom::Coordinates c = transform(wgs84, mercator, input[i]);
+        REQUIRE(coordinates[i].x == Approx(c.x));
+        REQUIRE(coordinates[i].y == Approx(c.y));
+    }
+}
+
 }
@@ -131,3 +131,58 @@ SECTION("empty_linestring") {
 
 }
 
+
+TEST_CASE("WKB_Geometry_into_buffer") {
+
+    osmium::memory::Buffer buffer(10000);
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {3.2, 4.2}},
+        {3, {3.5, 4.7}},
+        {4, {3.5, 4.7}},
+        {2, {3.6, 4.9}}
+    });
+    osmium::Area& area = buffer_add_area(buffer, "foo", {}, {
+        { true, {
+            {1, {0.1, 0.1}},
+            {2, {9.1, 0.1}},
+            {3, {9.1, 9.1}},
+            {4, {0.1, 9.1}},
+            {1, {0.1, 0.1}}
+        }},
+        { false, {
+            {5, {1.0, 1.0}},
+            {6, {4.0, 1.0}},
+            {6, {4.0, 1.0}},
+            {7, {4.0, 4.0}},
+            {5, {1.0, 1.0}}
+        }}
+    });
+
+    for (const auto wtype : {osmium::geom::wkb_type::wkb, osmium::geom::wkb_type::ewkb}) {
+        for (const auto otype : {osmium::geom::out_type::binary, osmium::geom::out_type::hex}) {
+            osmium::geom::WKBFactory<> factory(wtype, otype);
+
+            std::string out {"prefix"};
+            osmium::geom::WKBBufferFactory<> buffer_factory(out, wtype, otype);
+
+            const osmium::geom::output_range point = buffer_factory.create_point(osmium::Location(3.2, 4.2));
+            out += '|';
+            const osmium::geom::output_range linestring = buffer_factory.create_linestring(wnl);
+            const osmium::geom::output_range multipolygon = buffer_factory.create_multipolygon(area);
+
+            REQUIRE(point.offset == 6);
+            REQUIRE(point.size == osmium::geom::wkb_point_size(wtype, otype));
+            REQUIRE(out.substr(point.offset, point.size) == factory.create_point(osmium::Location(3.2, 4.2)));
+
+            REQUIRE(linestring.offset == point.offset + point.size + 1);
+            REQUIRE(linestring.size == osmium::geom::wkb_linestring_size(3, wtype, otype));
+            REQUIRE(out.substr(linestring.offset, linestring.size) == factory.create_linestring(wnl));
+
+            REQUIRE(multipolygon.offset == linestring.offset + linestring.size);
+            REQUIRE(multipolygon.size == osmium::geom::wkb_multipolygon_size(area, wtype, otype));
+            REQUIRE(out.substr(multipolygon.offset, multipolygon.size) == factory.create_multipolygon(area));
+            REQUIRE(out.size() == multipolygon.offset + multipolygon.size);
+        }
+    }
+
+}
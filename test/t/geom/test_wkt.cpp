@@ -202,5 +202,27 @@ SECTION("area_2outer_2inner") {
     }
 }
 
+
+SECTION("into_buffer") {
+    std::string out;
+    osmium::geom::WKTBufferFactory<> factory(out);
+
+    osmium::memory::Buffer buffer(10000);
+    auto& wnl = osmium::builder::build_way_node_list(buffer, {
+        {1, {3.2, 4.2}},
+        {2, {3.6, 4.9}}
+    });
+
+    const osmium::geom::output_range point = factory.create_point(osmium::Location(3.2, 4.2));
+    out += '\t';
+    const osmium::geom::output_range linestring = factory.create_linestring(wnl);
+
+    REQUIRE(std::string{"POINT(3.2 4.2)\tLINESTRING(3.2 4.2,3.6 4.9)"} == out);
+    REQUIRE(point.offset == 0);
+    REQUIRE(point.size == 14);
+    REQUIRE(linestring.offset == 15);
+    REQUIRE(linestring.size == out.size() - 15);
+}
+
 }
 
@@ -0,0 +1,183 @@
+#include "catch.hpp"
+
+#include <vector>
+
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include "../basic/helper.hpp"
+
+typedef osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> dense_index_type;
+typedef osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> sparse_index_type;
+typedef osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location> abstract_index_type;
+
+static osmium::Location location_for(osmium::object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id) * 2};
+}
+
+static void add_node(osmium::memory::Buffer& buffer, osmium::object_id_type id) {
+    buffer_add_node(buffer, "", {}, location_for(id)).set_id(id);
+}
+
+static void add_way(osmium::memory::Buffer& buffer, osmium::object_id_type id, const std::vector<osmium::object_id_type>& nodes) {
+    buffer_add_way(buffer, "", {}, nodes).set_id(id);
+}
+
+// Count the node refs of all ways in the buffer which have the location
+// expected for their ID.
+static int count_locations_set(const osmium::memory::Buffer& buffer) {
+    int count = 0;
+    for (auto it = buffer.cbegin<osmium::Way>(); it != buffer.cend<osmium::Way>(); ++it) {
+        for (const auto& node_ref : it->nodes()) {
+            if (node_ref.location() == location_for(node_ref.ref())) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+// Nodes with positive and negative IDs, a way with a missing node and
+// ways after it.
+static osmium::memory::Buffer create_buffer_with_missing_node() {
+    osmium::memory::Buffer buffer(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    for (osmium::object_id_type id = 1; id <= 10; ++id) {
+        add_node(buffer, id);
+        add_node(buffer, -id);
+    }
+    add_way(buffer, 1, {1, 99, 2});
+    add_way(buffer, 2, {3, 4, 5});
+    add_way(buffer, 3, {-1, -2, 6});
+    return buffer;
+}
+
+template <typename TIndexPos, typename TIndexNeg>
+void test_process_buffer(TIndexPos& index_pos, TIndexNeg& index_neg) {
+    osmium::handler::NodeLocationsForWays<TIndexPos, TIndexNeg> handler(index_pos, index_neg);
+    osmium::memory::Buffer buffer = create_buffer_with_missing_node();
+
+    SECTION("missing node throws after all ways are handled") {
+        REQUIRE_THROWS_AS(handler.process_buffer(buffer), osmium::not_found);
+        REQUIRE(count_locations_set(buffer) == 8);
+    }
+
+    SECTION("missing node is ignored") {
+        handler.ignore_errors();
+        handler.process_buffer(buffer);
+        REQUIRE(count_locations_set(buffer) == 8);
+    }
+
+    const auto& way = *buffer.cbegin<osmium::Way>();
+    REQUIRE(way.id() == 1);
+    REQUIRE(way.nodes()[0].location() == location_for(1));
+    REQUIRE_FALSE(way.nodes()[1].location());
+    REQUIRE(way.nodes()[2].location() == location_for(2));
+
+    REQUIRE(handler.get_node_location(-2) == location_for(-2));
+    REQUIRE(handler.get_node_location(10) == location_for(10));
+}
+
+TEST_CASE("NodeLocationsForWays process_buffer with dense index") {
+    dense_index_type index_pos;
+    dense_index_type index_neg;
+    test_process_buffer(index_pos, index_neg);
+}
+
+TEST_CASE("NodeLocationsForWays process_buffer with sparse index") {
+    sparse_index_type index_pos;
+    sparse_index_type index_neg;
+    test_process_buffer(index_pos, index_neg);
+}
+
+TEST_CASE("NodeLocationsForWays process_buffer with index of abstract type") {
+    sparse_index_type index_neg;
+
+    SECTION("dense index") {
+        dense_index_type index_pos;
+        test_process_buffer(static_cast<abstract_index_type&>(index_pos), index_neg);
+    }
+
+    SECTION("sparse index") {
+        sparse_index_type index_pos;
+        test_process_buffer(static_cast<abstract_index_type&>(index_pos), index_neg);
+    }
+}
+
+TEST_CASE("NodeLocationsForWays storing node locations on the thread pool") {
+
+    // Enough nodes for several pool tasks, in buffers small enough
+    // that not every buffer starts a task.
+    const osmium::object_id_type num_nodes = 150000;
+    const osmium::object_id_type nodes_per_buffer = 50000;
+
+    std::vector<osmium::memory::Buffer> node_buffers;
+    for (osmium::object_id_type first = 1; first <= num_nodes; first += nodes_per_buffer) {
+        node_buffers.emplace_back(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+        for (osmium::object_id_type id = first; id < first + nodes_per_buffer; ++id) {
+            add_node(node_buffers.back(), id);
+        }
+    }
+
+    dense_index_type index;
+    osmium::handler::NodeLocationsForWays<dense_index_type> handler(index);
+    handler.use_pool_threads_for_nodes();
+
+    for (auto& buffer : node_buffers) {
+        handler.process_buffer(buffer);
+    }
+
+    SECTION("flush stores all nodes") {
+        handler.flush();
+        REQUIRE(index.size() == num_nodes + 1);
+        osmium::object_id_type found = 0;
+        for (osmium::object_id_type id = 1; id <= num_nodes; ++id) {
+            if (handler.get_node_location(id) == location_for(id)) {
+                ++found;
+            }
+        }
+        REQUIRE(found == num_nodes);
+    }
+
+    SECTION("ways in a buffer after the nodes") {
+        osmium::memory::Buffer ways(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+        int num_refs = 0;
+        for (osmium::object_id_type id = 1; id < num_nodes; id += 100) {
+            add_way(ways, id, {id, id + 1, num_nodes - id});
+            num_refs += 3;
+        }
+
+        handler.process_buffer(ways);
+        REQUIRE(count_locations_set(ways) == num_refs);
+    }
+
+    SECTION("buffer with nodes and ways mixed") {
+        handler.ignore_errors();
+
+        osmium::memory::Buffer buffer(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+        for (osmium::object_id_type id = num_nodes + 1; id <= num_nodes + 100; ++id) {
+            add_node(buffer, id);
+            add_way(buffer, id, {id - num_nodes, id});
+        }
+        // node 1000000 comes after this way, so it must not be found
+        add_way(buffer, 1, {1, 1000000});
+        add_node(buffer, 1000000);
+
+        handler.process_buffer(buffer);
+        REQUIRE(count_locations_set(buffer) == 2 * 100 + 1);
+
+        for (auto it = buffer.cbegin<osmium::Way>(); it != buffer.cend<osmium::Way>(); ++it) {
+            if (it->id() == 1) {
+                REQUIRE_FALSE(it->nodes()[1].location());
+            }
+        }
+
+        handler.flush();
+        REQUIRE(index.size() == 1000000 + 1);
+        REQUIRE(handler.get_node_location(num_nodes) == location_for(num_nodes));
+        REQUIRE(handler.get_node_location(num_nodes + 100) == location_for(num_nodes + 100));
+        REQUIRE(handler.get_node_location(1000000) == location_for(1000000));
+    }
+
+}
@@ -0,0 +1,212 @@
+#include "catch.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include <osmium/diff_visitor.hpp>
+#include <osmium/handler/node_locations_updater.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/multimap/sparse_mem_array.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/visitor.hpp>
+
+typedef osmium::index::multimap::SparseMemArray<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type> node_way_index_type;
+
+static const char* change_file =
+    "<?xml version='1.0' encoding='UTF-8'?>\n"
+    "<osmChange version='0.6' generator='test'>\n"
+    " <modify>\n"
+    "  <node id='1' version='2' lat='1.5' lon='1.5'/>\n"
+    "  <node id='2' version='2' lat='2' lon='2'/>\n"
+    " </modify>\n"
+    " <delete>\n"
+    "  <node id='3' version='2'/>\n"
+    " </delete>\n"
+    " <create>\n"
+    "  <node id='20' version='1' lat='20' lon='20'/>\n"
+    "  <way id='12' version='1'>\n"
+    "   <nd ref='1'/>\n"
+    "   <nd ref='20'/>\n"
+    "  </way>\n"
+    " </create>\n"
+    "</osmChange>\n";
+
+static const char* create_delete_change_file =
+    "<?xml version='1.0' encoding='UTF-8'?>\n"
+    "<osmChange version='0.6' generator='test'>\n"
+    " <create>\n"
+    "  <node id='5' version='1' lat='2' lon='2'/>\n"
+    "  <node id='6' version='1' lat='6' lon='6'/>\n"
+    " </create>\n"
+    " <delete>\n"
+    "  <node id='5' version='2'/>\n"
+    " </delete>\n"
+    "</osmChange>\n";
+
+static const char* history_file =
+    "<?xml version='1.0' encoding='UTF-8'?>\n"
+    "<osm version='0.6' generator='test'>\n"
+    "  <node id='1' version='1' timestamp='2015-01-01T00:00:00Z' lat='1' lon='1'/>\n"
+    "  <node id='1' version='2' timestamp='2015-02-01T00:00:00Z' lat='1.5' lon='1.5'/>\n"
+    "  <node id='3' version='1' timestamp='2015-01-01T00:00:00Z' lat='3' lon='3'/>\n"
+    "  <node id='3' version='2' timestamp='2015-02-01T00:00:00Z' visible='false'/>\n"
+    "  <node id='5' version='1' timestamp='2015-01-01T00:00:00Z' lat='5' lon='5'/>\n"
+    "  <node id='5' version='2' timestamp='2015-02-01T00:00:00Z' visible='false'/>\n"
+    "  <node id='6' version='1' timestamp='2015-02-01T00:00:00Z' lat='6' lon='6'/>\n"
+    "</osm>\n";
+
+template <typename TIndex>
+bool has_location(const TIndex& index, osmium::unsigned_object_id_type id) {
+    osmium::Location location;
+    index.get_many(&id, &location, 1);
+    return location.valid();
+}
+
+template <typename TIndex>
+void fill_index(TIndex& index) {
+    index.set(1, osmium::Location{1.0, 1.0});
+    index.set(2, osmium::Location{2.0, 2.0});
+    index.set(3, osmium::Location{3.0, 3.0});
+    index.set(4, osmium::Location{4.0, 4.0});
+    index.sort();
+}
+
+template <typename TIndex>
+void test_update(TIndex& index) {
+    node_way_index_type node_way_index;
+    node_way_index.set(1, 10);
+    node_way_index.set(2, 10);
+    node_way_index.set(3, 11);
+    node_way_index.set(4, 11);
+    node_way_index.set(4, 13);
+    node_way_index.sort();
+
+    osmium::handler::NodeLocationsUpdater<TIndex> updater(index, node_way_index);
+
+    osmium::io::Reader reader(osmium::io::File{change_file, std::strlen(change_file), "osc"});
+    osmium::apply(reader, updater);
+    reader.close();
+
+    const std::vector<osmium::unsigned_object_id_type> expected_ways = { 10, 11, 12 };
+    REQUIRE(updater.affected_ways() == expected_ways);
+
+    const std::vector<osmium::unsigned_object_id_type> expected_nodes = { 1, 3 };
+    REQUIRE(updater.moved_nodes() == expected_nodes);
+
+    REQUIRE(index.get(1) == osmium::Location(1.5, 1.5));
+    REQUIRE(index.get(2) == osmium::Location(2.0, 2.0));
+
+    // deleted node
+    const osmium::unsigned_object_id_type id = 3;
+    osmium::Location location;
+    index.get_many(&id, &location, 1);
+    REQUIRE_FALSE(location);
+
+    REQUIRE(index.get(4) == osmium::Location(4.0, 4.0));
+    REQUIRE(index.get(20) == osmium::Location(20.0, 20.0));
+}
+
+TEST_CASE("Update node locations from change file") {
+
+    SECTION("dense index") {
+        typedef osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
+        index_type index;
+        fill_index(index);
+        test_update(index);
+        REQUIRE(index.size() == 21);
+    }
+
+    SECTION("sparse index") {
+        typedef osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
+        index_type index;
+        fill_index(index);
+        test_update(index);
+        REQUIRE(index.size() == 5);
+    }
+
+    SECTION("dense file index") {
+        typedef osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
+        index_type index{osmium::detail::create_tmp_file()};
+        fill_index(index);
+        test_update(index);
+        REQUIRE(index.size() == 21);
+    }
+
+    SECTION("sparse file index") {
+        typedef osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
+        index_type index{osmium::detail::create_tmp_file()};
+        fill_index(index);
+        test_update(index);
+        REQUIRE(index.size() == 5);
+    }
+
+}
+
+template <typename TIndex>
+void test_create_delete(TIndex& index) {
+    osmium::handler::NodeLocationsUpdater<TIndex> updater(index);
+
+    osmium::io::Reader reader(osmium::io::File{create_delete_change_file, std::strlen(create_delete_change_file), "osc"});
+    osmium::apply(reader, updater);
+    reader.close();
+    updater.flush();
+
+    REQUIRE_FALSE(has_location(index, 5));
+    REQUIRE(index.get(6) == osmium::Location(6.0, 6.0));
+}
+
+TEST_CASE("Node created and deleted in the same change file") {
+
+    SECTION("dense index") {
+        osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        fill_index(index);
+        test_create_delete(index);
+    }
+
+    SECTION("sparse index") {
+        osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        fill_index(index);
+        test_create_delete(index);
+        REQUIRE(index.size() == 5);
+    }
+
+}
+
+template <typename TIndex>
+void test_history(TIndex& index) {
+    osmium::handler::NodeLocationsUpdater<TIndex> updater(index);
+
+    osmium::io::Reader reader(osmium::io::File{history_file, std::strlen(history_file), "osh"});
+    osmium::apply_diff(reader, updater);
+    reader.close();
+    updater.flush();
+
+    REQUIRE(index.get(1) == osmium::Location(1.5, 1.5));
+    REQUIRE(index.get(2) == osmium::Location(2.0, 2.0));
+    REQUIRE_FALSE(has_location(index, 3));
+    REQUIRE_FALSE(has_location(index, 5));
+    REQUIRE(index.get(6) == osmium::Location(6.0, 6.0));
+
+    const std::vector<osmium::unsigned_object_id_type> expected_nodes = { 1, 3 };
+    REQUIRE(updater.moved_nodes() == expected_nodes);
+}
+
+TEST_CASE("Update node locations from history file with apply_diff") {
+
+    SECTION("dense file index") {
+        osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location> index{osmium::detail::create_tmp_file()};
+        fill_index(index);
+        test_history(index);
+    }
+
+    SECTION("sparse file index") {
+        osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location> index{osmium::detail::create_tmp_file()};
+        fill_index(index);
+        test_history(index);
+    }
+
+}
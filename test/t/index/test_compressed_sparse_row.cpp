@@ -0,0 +1,88 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <osmium/index/multimap/compressed_sparse_row.hpp>
+
+typedef osmium::index::multimap::CompressedSparseRowMultimap<uint64_t, uint64_t> index_type;
+
+static std::vector<uint64_t> values_for(const index_type& index, uint64_t id) {
+    std::vector<uint64_t> values;
+    const auto range = index.get_all(id);
+    for (auto it = range.first; it != range.second; ++it) {
+        REQUIRE(it->first == id);
+        values.push_back(it->second);
+    }
+    return values;
+}
+
+TEST_CASE("CompressedSparseRowMultimap") {
+
+    index_type index;
+
+    SECTION("empty index") {
+        index.sort();
+        REQUIRE(index.size() == 0);
+        REQUIRE(values_for(index, 17).empty());
+    }
+
+    SECTION("several values per id") {
+        index.set(20, 3);
+        index.set(10, 2);
+        index.set(20, 1);
+        index.set(10, 1);
+        index.set(30, 5);
+        index.sort();
+
+        REQUIRE(index.size() == 5);
+        REQUIRE(index.num_ids() == 3);
+        REQUIRE(values_for(index, 10) == (std::vector<uint64_t>{1, 2}));
+        REQUIRE(values_for(index, 20) == (std::vector<uint64_t>{1, 3}));
+        REQUIRE(values_for(index, 30) == (std::vector<uint64_t>{5}));
+        REQUIRE(values_for(index, 0).empty());
+        REQUIRE(values_for(index, 15).empty());
+        REQUIRE(values_for(index, 31).empty());
+    }
+
+    SECTION("set after sort") {
+        index.set(10, 1);
+        index.set(20, 2);
+        index.sort();
+
+        index.set(10, 3);
+        index.set(15, 4);
+        REQUIRE(index.size() == 4);
+        index.sort();
+
+        REQUIRE(index.num_ids() == 3);
+        REQUIRE(values_for(index, 10) == (std::vector<uint64_t>{1, 3}));
+        REQUIRE(values_for(index, 15) == (std::vector<uint64_t>{4}));
+        REQUIRE(values_for(index, 20) == (std::vector<uint64_t>{2}));
+    }
+
+    SECTION("many ids and large gaps") {
+        const uint64_t big = 1ULL << 40;
+        for (uint64_t id = 1; id <= 10000; ++id) {
+            index.set(id * 7, id);
+            if (id % 3 == 0) {
+                index.set(id * 7, id + 1);
+            }
+        }
+        index.set(big, 1);
+        index.set(big + 1, 2);
+        index.sort();
+
+        REQUIRE(index.num_ids() == 10002);
+        for (uint64_t id = 1; id <= 10000; ++id) {
+            REQUIRE(values_for(index, id * 7).size() == (id % 3 == 0 ? 2 : 1));
+            REQUIRE(values_for(index, id * 7 + 1).empty());
+        }
+        REQUIRE(values_for(index, big) == (std::vector<uint64_t>{1}));
+        REQUIRE(values_for(index, big + 1) == (std::vector<uint64_t>{2}));
+        REQUIRE(values_for(index, big - 1).empty());
+        REQUIRE(values_for(index, big + 2).empty());
+    }
+
+}
+
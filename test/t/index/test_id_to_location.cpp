@@ -1,8 +1,12 @@
 #include "catch.hpp"
 
+#include <thread>
+#include <vector>
+
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/location.hpp>
 
+#include <osmium/index/map/compressed_mem_array.hpp>
 #include <osmium/index/map/dense_file_array.hpp>
 #include <osmium/index/map/dense_mem_array.hpp>
 #include <osmium/index/map/dense_mmap_array.hpp>
@@ -48,6 +52,14 @@ void test_func_real(TIndex& index) {
     REQUIRE(loc1 == index.get(id1));
     REQUIRE(loc2 == index.get(id2));
 
+    const osmium::unsigned_object_id_type ids[4] = { id1, 5, id2, 100 };
+    osmium::Location locations[4];
+    index.get_many(ids, locations, 4);
+    REQUIRE(loc1 == locations[0]);
+    REQUIRE_FALSE(locations[1]);
+    REQUIRE(loc2 == locations[2]);
+    REQUIRE_FALSE(locations[3]);
+
     REQUIRE_THROWS_AS(index.get(5), osmium::not_found);
     REQUIRE_THROWS_AS(index.get(100), osmium::not_found);
 
@@ -56,6 +68,101 @@ void test_func_real(TIndex& index) {
     REQUIRE_THROWS_AS(index.get(id1), osmium::not_found);
 }
 
+template <typename TIndex>
+void test_func_get_many(TIndex& index) {
+    for (osmium::unsigned_object_id_type id = 10; id < 2000; id += 2) {
+        index.set(id, osmium::Location(static_cast<int32_t>(id), static_cast<int32_t>(id + 1)));
+    }
+
+    index.sort();
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 2100; id > 0; id -= 7) {
+        ids.push_back(id);
+    }
+    std::vector<osmium::Location> locations(ids.size());
+
+    index.get_many(ids.data(), locations.data(), ids.size());
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i] >= 10 && ids[i] < 2000 && ids[i] % 2 == 0) {
+            REQUIRE(locations[i] == osmium::Location(static_cast<int32_t>(ids[i]), static_cast<int32_t>(ids[i] + 1)));
+        } else {
+            REQUIRE_FALSE(locations[i]);
+        }
+    }
+}
+
+template <typename TIndex>
+void test_func_large(TIndex& index) {
+    // enough locations for the sparse maps to build a search index
+    const osmium::unsigned_object_id_type max_id = 1600000;
+    for (osmium::unsigned_object_id_type id = max_id; id > 0; --id) {
+        if (id % 3 != 0) {
+            index.set(id, osmium::Location(static_cast<int32_t>(id), 7));
+        }
+    }
+
+    index.sort();
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 0; id <= max_id + 1; ++id) {
+        ids.push_back(id);
+    }
+    std::vector<osmium::Location> locations(ids.size());
+    index.get_many(ids.data(), locations.data(), ids.size());
+
+    size_t errors = 0;
+    for (const auto id : ids) {
+        const bool exists = id > 0 && id <= max_id && id % 3 != 0;
+        const osmium::Location expected = exists ? osmium::Location(static_cast<int32_t>(id), 7) : osmium::Location();
+        if (locations[id] != expected) {
+            ++errors;
+        }
+        if (exists && id % 1000 == 1 && index.get(id) != expected) {
+            ++errors;
+        }
+    }
+    REQUIRE(errors == 0);
+
+    REQUIRE(index.get(1) == osmium::Location(1, 7));
+    REQUIRE(index.get(max_id) == osmium::Location(static_cast<int32_t>(max_id), 7));
+    REQUIRE_THROWS_AS(index.get(0), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(3), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(max_id / 3 * 3), osmium::not_found);
+    REQUIRE_THROWS_AS(index.get(max_id + 1), osmium::not_found);
+}
+
+template <typename TIndex>
+void test_func_concurrent_set(TIndex& index) {
+    const osmium::unsigned_object_id_type max_id = 100000;
+    const int num_threads = 4;
+
+    index.resize(max_id + 1);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&index, t]() {
+            for (osmium::unsigned_object_id_type id = t + 1; id <= max_id; id += num_threads) {
+                index.set_concurrently(id, osmium::Location(static_cast<int32_t>(id), 3));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(index.size() == max_id + 1);
+    size_t errors = 0;
+    for (osmium::unsigned_object_id_type id = 1; id <= max_id; ++id) {
+        if (index.get(id) != osmium::Location(static_cast<int32_t>(id), 3)) {
+            ++errors;
+        }
+    }
+    REQUIRE(errors == 0);
+    REQUIRE_THROWS_AS(index.get(0), osmium::not_found);
+}
+
 TEST_CASE("IdToLocation") {
 
     SECTION("Dummy") {
@@ -75,6 +182,16 @@ TEST_CASE("IdToLocation") {
     SECTION("DenseMemArray") {
         typedef osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
 
+        {
+            index_type index;
+            test_func_get_many<index_type>(index);
+        }
+
+        {
+            index_type index;
+            test_func_concurrent_set<index_type>(index);
+        }
+
         index_type index1;
         index1.reserve(1000);
         test_func_all<index_type>(index1);
@@ -93,6 +210,9 @@ TEST_CASE("IdToLocation") {
 
         index_type index2;
         test_func_real<index_type>(index2);
+
+        index_type index3;
+        test_func_concurrent_set<index_type>(index3);
     }
 #else
 # pragma message("not running 'DenseMapMmap' test case on this machine")
@@ -108,6 +228,52 @@ TEST_CASE("IdToLocation") {
         test_func_real<index_type>(index2);
     }
 
+    SECTION("CompressedMemArray") {
+        typedef osmium::index::map::CompressedMemArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
+
+        {
+            index_type index;
+            test_func_get_many<index_type>(index);
+        }
+
+        index_type index1;
+        test_func_all<index_type>(index1);
+
+        index_type index2;
+        test_func_real<index_type>(index2);
+    }
+
+    SECTION("CompressedMemArray with many locations") {
+        typedef osmium::index::map::CompressedMemArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
+
+        index_type index;
+
+        // ascending IDs with gaps spanning several blocks
+        for (osmium::unsigned_object_id_type id = 1; id < 10000; id += 3) {
+            index.set(id, osmium::Location(static_cast<int32_t>(id * 1000), -static_cast<int32_t>(id * 7)));
+        }
+
+        // going back to a block already written
+        index.set(1001, osmium::Location(1.5, 2.5));
+        index.set(5000, osmium::Location(-180.0, 90.0));
+
+        index.sort();
+
+        REQUIRE(index.size() == 3335);
+        REQUIRE(index.garbage() > 0);
+
+        for (osmium::unsigned_object_id_type id = 1; id < 10000; id += 3) {
+            if (id != 1001) {
+                REQUIRE(index.get(id) == osmium::Location(static_cast<int32_t>(id * 1000), -static_cast<int32_t>(id * 7)));
+            }
+        }
+        REQUIRE(index.get(1001) == osmium::Location(1.5, 2.5));
+        REQUIRE(index.get(5000) == osmium::Location(-180.0, 90.0));
+        REQUIRE_THROWS_AS(index.get(2), osmium::not_found);
+        REQUIRE_THROWS_AS(index.get(10000), osmium::not_found);
+        REQUIRE_THROWS_AS(index.get(1000000), osmium::not_found);
+    }
+
 #ifdef OSMIUM_WITH_SPARSEHASH
 
     SECTION("SparseMemTable") {
@@ -125,6 +291,11 @@ TEST_CASE("IdToLocation") {
     SECTION("SparseMemMap") {
         typedef osmium::index::map::SparseMemMap<osmium::unsigned_object_id_type, osmium::Location> index_type;
 
+        {
+            index_type index;
+            test_func_get_many<index_type>(index);
+        }
+
         index_type index1;
         test_func_all<index_type>(index1);
 
@@ -135,6 +306,16 @@ TEST_CASE("IdToLocation") {
     SECTION("SparseMemArray") {
         typedef osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index_type;
 
+        {
+            index_type index;
+            test_func_large<index_type>(index);
+        }
+
+        {
+            index_type index;
+            test_func_get_many<index_type>(index);
+        }
+
         index_type index1;
 
         REQUIRE(0 == index1.size());
@@ -163,6 +344,9 @@ TEST_CASE("IdToLocation") {
             std::unique_ptr<map_type> index2 = map_factory.create_map(map_type_name);
             index2->reserve(1000);
             test_func_real<map_type>(*index2);
+
+            std::unique_ptr<map_type> index3 = map_factory.create_map(map_type_name);
+            test_func_large<map_type>(*index3);
         }
     }
 
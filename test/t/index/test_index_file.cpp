@@ -0,0 +1,119 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <unistd.h>
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/index_file.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/index_file_map.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+typedef osmium::index::map::IndexFileMap<osmium::unsigned_object_id_type, osmium::Location> index_file_map_type;
+
+static const osmium::Location loc1{1.2, 4.5};
+static const osmium::Location loc2{3.5, -7.2};
+
+TEST_CASE("Index file") {
+
+    osmium::index::index_file_source source;
+    source.timestamp = osmium::Timestamp("2015-12-01T12:00:00Z");
+    source.sequence_number = 1234;
+
+    const int fd = osmium::detail::create_tmp_file();
+
+    SECTION("dense") {
+        osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        index.set(7, loc1);
+        index.set(12, loc2);
+        osmium::index::write_index_file(fd, index, source);
+
+        index_file_map_type map{fd};
+        REQUIRE(map.header().data_type() == osmium::index::index_file_type::dense);
+        REQUIRE(map.header().sorted());
+        REQUIRE(map.header().num_elements == 13);
+        REQUIRE(map.header().min_id == 0);
+        REQUIRE(map.header().max_id == 12);
+        REQUIRE(map.header().source().timestamp == source.timestamp);
+        REQUIRE(map.header().source().sequence_number == 1234);
+        REQUIRE(map.size() == 13);
+
+        REQUIRE(map.get(7) == loc1);
+        REQUIRE(map.get(12) == loc2);
+        REQUIRE_THROWS_AS(map.get(0), osmium::not_found);
+        REQUIRE_THROWS_AS(map.get(13), osmium::not_found);
+        REQUIRE_THROWS_AS(map.set(1, loc1), std::runtime_error);
+
+        const osmium::unsigned_object_id_type ids[3] = { 12, 8, 7 };
+        osmium::Location locations[3];
+        map.get_many(ids, locations, 3);
+        REQUIRE(locations[0] == loc2);
+        REQUIRE_FALSE(locations[1]);
+        REQUIRE(locations[2] == loc1);
+    }
+
+    SECTION("sparse") {
+        osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        index.set(1000, loc2);
+        index.set(5, loc1);
+        osmium::index::write_index_file(fd, index, source);
+
+        index_file_map_type map{fd};
+        REQUIRE(map.header().data_type() == osmium::index::index_file_type::sparse);
+        REQUIRE(map.header().sorted());
+        REQUIRE(map.header().num_elements == 2);
+        REQUIRE(map.header().min_id == 5);
+        REQUIRE(map.header().max_id == 1000);
+        REQUIRE(map.size() == 2);
+
+        REQUIRE(map.get(5) == loc1);
+        REQUIRE(map.get(1000) == loc2);
+        REQUIRE_THROWS_AS(map.get(6), osmium::not_found);
+
+        const osmium::unsigned_object_id_type ids[3] = { 1000, 6, 5 };
+        osmium::Location locations[3];
+        map.get_many(ids, locations, 3);
+        REQUIRE(locations[0] == loc2);
+        REQUIRE_FALSE(locations[1]);
+        REQUIRE(locations[2] == loc1);
+    }
+
+    SECTION("wrong value type") {
+        osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        index.set(7, loc1);
+        osmium::index::write_index_file(fd, index);
+
+        typedef osmium::index::map::IndexFileMap<osmium::unsigned_object_id_type, uint32_t> wrong_map_type;
+        REQUIRE_THROWS_AS(wrong_map_type{fd}, osmium::index_file_error);
+    }
+
+    SECTION("not an index file") {
+        REQUIRE(::write(fd, "not an index file", 17) == 17);
+        REQUIRE_THROWS_AS(index_file_map_type{fd}, osmium::index_file_error);
+    }
+
+    SECTION("truncated index file") {
+        osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        index.set(7, loc1);
+        osmium::index::write_index_file(fd, index);
+        REQUIRE(::ftruncate(fd, sizeof(osmium::index::index_file_header) + 8) == 0);
+        REQUIRE_THROWS_AS(index_file_map_type{fd}, osmium::index_file_error);
+    }
+
+    SECTION("number of elements in header too large") {
+        osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+        index.set(7, loc1);
+        osmium::index::write_index_file(fd, index);
+
+        // num_elements * element_size overflows to 8 bytes here
+        auto header = osmium::index::read_index_file_header(fd);
+        header.num_elements = (uint64_t(1) << 61) + 1;
+        REQUIRE(::pwrite(fd, &header, sizeof(header), 0) == sizeof(header));
+        REQUIRE_THROWS_AS(index_file_map_type{fd}, osmium::index_file_error);
+    }
+
+    ::close(fd);
+}
+
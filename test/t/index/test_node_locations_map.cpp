@@ -0,0 +1,84 @@
+#include "catch.hpp"
+
+#include <string>
+
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/dummy.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+
+#include <osmium/index/node_locations_map.hpp>
+
+typedef osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location> map_type;
+typedef osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location> dense_mem_array_type;
+typedef osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> sparse_mem_array_type;
+typedef osmium::index::map::Dummy<osmium::unsigned_object_id_type, osmium::Location> dummy_type;
+
+// Records the type of the map it was called with.
+class type_recorder {
+
+    std::string& m_name;
+
+public:
+
+    explicit type_recorder(std::string& name) :
+        m_name(name) {
+    }
+
+    void operator()(dense_mem_array_type&) const {
+        m_name = "dense_mem_array";
+    }
+
+    void operator()(sparse_mem_array_type&) const {
+        m_name = "sparse_mem_array";
+    }
+
+    void operator()(map_type&) const {
+        m_name = "map";
+    }
+
+    template <typename TMap>
+    void operator()(TMap&) const {
+        m_name = "other";
+    }
+
+}; // class type_recorder
+
+TEST_CASE("call_with_concrete_map") {
+    std::string name;
+
+    SECTION("dense map through abstract map type") {
+        dense_mem_array_type map;
+        osmium::index::call_with_concrete_map(static_cast<map_type&>(map), type_recorder{name});
+        REQUIRE(name == "dense_mem_array");
+    }
+
+    SECTION("sparse map through abstract map type") {
+        sparse_mem_array_type map;
+        osmium::index::call_with_concrete_map(static_cast<map_type&>(map), type_recorder{name});
+        REQUIRE(name == "sparse_mem_array");
+    }
+
+    SECTION("unknown map through abstract map type is passed as is") {
+        dummy_type map;
+        osmium::index::call_with_concrete_map(static_cast<map_type&>(map), type_recorder{name});
+        REQUIRE(name == "map");
+    }
+
+    SECTION("concrete map type is passed as is") {
+        dummy_type map;
+        osmium::index::call_with_concrete_map(map, type_recorder{name});
+        REQUIRE(name == "other");
+    }
+
+    SECTION("functor gets the map itself, not a copy") {
+        dense_mem_array_type map;
+        const osmium::Location location{1.5, 2.5};
+        osmium::index::call_with_concrete_map(static_cast<map_type&>(map), [&location](map_type& m) {
+            m.set(17, location);
+        });
+        REQUIRE(map.get(17) == location);
+    }
+}
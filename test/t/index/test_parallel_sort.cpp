@@ -0,0 +1,105 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <osmium/index/detail/mmap_vector_anon.hpp>
+#include <osmium/index/detail/parallel_sort.hpp>
+#include <osmium/thread/pool.hpp>
+
+typedef std::pair<uint64_t, uint64_t> element_type;
+
+static std::vector<element_type> random_data(size_t size, uint64_t max_key) {
+    std::mt19937_64 gen(42);
+    std::uniform_int_distribution<uint64_t> keys(0, max_key);
+    std::uniform_int_distribution<uint64_t> values(0, 100);
+
+    std::vector<element_type> data;
+    data.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        data.emplace_back(keys(gen), values(gen));
+    }
+    return data;
+}
+
+TEST_CASE("Parallel radix sort") {
+
+    osmium::thread::Pool& pool = osmium::thread::Pool::instance();
+
+    SECTION("gives same result as std::sort") {
+        for (uint64_t max_key : { 10ull, 1000000ull, 10000000000ull }) {
+            std::vector<element_type> data = random_data(100000, max_key);
+            std::vector<element_type> expected = data;
+            std::sort(expected.begin(), expected.end());
+
+            osmium::index::detail::parallel_radix_sort(pool, 7, data.data(), data.size());
+            REQUIRE(data == expected);
+        }
+    }
+
+    SECTION("keys with a byte that is the same in all keys") {
+        std::vector<element_type> data = random_data(100000, 1000000);
+        for (auto& element : data) {
+            element.first = (element.first << 8) | 0x42;
+        }
+        std::vector<element_type> expected = data;
+        std::sort(expected.begin(), expected.end());
+
+        osmium::index::detail::parallel_radix_sort(pool, 7, data.data(), data.size());
+        REQUIRE(data == expected);
+    }
+
+    SECTION("parallel is_sorted") {
+        std::vector<element_type> data = random_data(100000, 1000000);
+        REQUIRE_FALSE(osmium::index::detail::parallel_is_sorted(pool, 4, data.data(), data.size()));
+        std::sort(data.begin(), data.end());
+        REQUIRE(osmium::index::detail::parallel_is_sorted(pool, 4, data.data(), data.size()));
+
+        // unsorted only at a chunk boundary
+        std::swap(data[49999], data[50000]);
+        REQUIRE_FALSE(osmium::index::detail::parallel_is_sorted(pool, 2, data.data(), data.size()));
+    }
+
+    SECTION("sort_pairs on large mmap vector") {
+        const std::vector<element_type> data = random_data(osmium::index::detail::min_parallel_sort_size + 1000, 20000000000ull);
+
+        osmium::detail::mmap_vector_anon<element_type> vector;
+        for (const auto& element : data) {
+            vector.push_back(element);
+        }
+
+        osmium::index::detail::sort_pairs(vector);
+
+        REQUIRE(std::is_sorted(vector.begin(), vector.end()));
+        REQUIRE(vector.size() == data.size());
+    }
+
+    SECTION("sort_pairs in a pool task doesn't wait for other tasks") {
+        std::vector<element_type> data = random_data(osmium::index::detail::min_parallel_sort_size + 1000, 20000000000ull);
+        std::vector<element_type> expected = data;
+        std::sort(expected.begin(), expected.end());
+
+        // Occupy all workers with tasks sorting large vectors, so they
+        // would deadlock if the sort waited for other pool tasks.
+        std::vector<std::vector<element_type>> vectors(static_cast<size_t>(pool.num_threads()), data);
+        std::vector<std::future<void>> futures;
+        for (auto& vector : vectors) {
+            futures.push_back(pool.submit([&vector] {
+                osmium::index::detail::sort_pairs(vector);
+            }));
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+
+        for (const auto& vector : vectors) {
+            REQUIRE(vector == expected);
+        }
+    }
+
+}
+
@@ -74,6 +74,11 @@ TEST_CASE("UTF8 encoding") {
         REQUIRE(out == "%20%%0a%%2c%%3d%%40%");
     }
 
+    SECTION("encode characters that are special in OPL in long strings") {
+        osmium::io::detail::append_utf8_encoded_string(out, "Mo-Fr_08:00-18:00,Sa_09:00-12:00@100%");
+        REQUIRE(out == "Mo-Fr_08:00-18:00%2c%Sa_09:00-12:00%40%100%25%");
+    }
+
 // workaround for missing support for u8 string literals on Windows
 #if !defined(_MSC_VER)
 
@@ -102,6 +107,12 @@ TEST_CASE("html encoding") {
         REQUIRE(out == "&amp; &quot; &apos; &lt; &gt; &#xA; &#xD; &#x9;");
     }
 
+    SECTION("encode special XML characters in long strings") {
+        const char* s = "Fish & Chips \"The Anchor\" <closed> on Sundays";
+        osmium::io::detail::append_xml_encoded_string(out, s);
+        REQUIRE(out == "Fish &amp; Chips &quot;The Anchor&quot; &lt;closed&gt; on Sundays");
+    }
+
 }
 
 TEST_CASE("debug encoding") {
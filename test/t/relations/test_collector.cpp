@@ -0,0 +1,206 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/relations/collector.hpp>
+#include <osmium/visitor.hpp>
+
+#include "../basic/helper.hpp"
+
+class TestCollector : public osmium::relations::Collector<TestCollector, false, true, false> {
+
+public:
+
+    int complete = 0;
+    int members_found = 0;
+    size_t max_committed = 0;
+
+    void complete_relation(osmium::relations::RelationMeta& relation_meta) {
+        ++complete;
+        max_committed = std::max(max_committed, members_buffer().committed());
+        for (const auto& member : get_relation(relation_meta).members()) {
+            if (member.ref() != 0) {
+                const auto& way = get_member(get_offset(member.type(), member.ref()));
+                if (way.id() == member.ref()) {
+                    ++members_found;
+                }
+            }
+        }
+    }
+
+    size_t num_way_member_metas() {
+        return member_meta(osmium::item_type::way).size();
+    }
+
+}; // class TestCollector
+
+TEST_CASE("Collector with members buffer on disk") {
+
+    osmium::memory::Buffer relations(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        buffer_add_relation(relations, "", {}, {
+            std::make_tuple('w', id, ""),
+            std::make_tuple('w', id + 1, "")
+        }).set_id(id);
+    }
+
+    osmium::memory::Buffer ways(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    for (osmium::object_id_type id = 1; id <= 1001; ++id) {
+        buffer_add_way(ways, "", {}, std::vector<osmium::object_id_type>{id, id + 1}).set_id(id);
+    }
+
+    TestCollector collector;
+
+    SECTION("in memory") {
+        collector.read_relations(relations.begin(), relations.end());
+        osmium::apply(ways, collector.handler());
+        REQUIRE_FALSE(collector.members_on_disk());
+    }
+
+    SECTION("on disk") {
+        // less than the two ways a relation needs at the same time
+        collector.set_members_memory_budget(100);
+        collector.read_relations(relations.begin(), relations.end());
+        osmium::apply(ways, collector.handler());
+        REQUIRE(collector.members_on_disk());
+    }
+
+    REQUIRE(collector.complete == 1000);
+    REQUIRE(collector.members_found == 2000);
+}
+
+TEST_CASE("Collector keeps members buffer within memory budget") {
+
+    // One relation with many members, so all of them are in the members
+    // buffer at the same time.
+    const osmium::object_id_type num_ways = 15000;
+
+    osmium::memory::Buffer relations(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    std::vector<std::tuple<char, osmium::object_id_type, const char*>> members;
+    for (osmium::object_id_type id = 1; id <= num_ways; ++id) {
+        members.emplace_back('w', id, "");
+    }
+    buffer_add_relation(relations, "", {}, members).set_id(1);
+
+    osmium::memory::Buffer ways(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    for (osmium::object_id_type id = 1; id <= num_ways; ++id) {
+        buffer_add_way(ways, "", {}, std::vector<osmium::object_id_type>{id, id + 1}).set_id(id);
+    }
+
+    TestCollector collector;
+
+    SECTION("buffer grows only up to the budget") {
+        const size_t budget = 3 * 1024 * 1024 / 2;
+        collector.set_members_memory_budget(budget);
+        collector.read_relations(relations.begin(), relations.end());
+        osmium::apply(ways, collector.handler());
+        REQUIRE_FALSE(collector.members_on_disk());
+        REQUIRE(collector.max_committed > 1024 * 1024);
+        REQUIRE(collector.members_buffer().capacity() <= budget);
+    }
+
+    SECTION("buffer smaller than the budget at the start") {
+        const size_t budget = 64 * 1024;
+        collector.set_members_memory_budget(budget);
+        REQUIRE(collector.members_buffer().capacity() <= budget);
+        collector.read_relations(relations.begin(), relations.end());
+        osmium::apply(ways, collector.handler());
+        REQUIRE(collector.members_on_disk());
+    }
+
+    REQUIRE(collector.complete == 1);
+    REQUIRE(collector.members_found == num_ways);
+}
+
+TEST_CASE("Collector erases removed member metas while reading members") {
+
+    // The member metas of complete relations are erased after every
+    // 10000 complete relations, so this needs more than that.
+    const osmium::object_id_type num_relations = 25000;
+
+    osmium::memory::Buffer relations(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    osmium::memory::Buffer ways(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    TestCollector collector;
+
+    SECTION("members shared with the next relation") {
+        for (osmium::object_id_type id = 1; id <= num_relations; ++id) {
+            buffer_add_relation(relations, "", {}, {
+                std::make_tuple('w', id, ""),
+                std::make_tuple('w', id + 1, "")
+            }).set_id(id);
+        }
+        for (osmium::object_id_type id = 1; id <= num_relations + 1; ++id) {
+            buffer_add_way(ways, "", {}, std::vector<osmium::object_id_type>{id, id + 1}).set_id(id);
+        }
+
+        collector.read_relations(relations.begin(), relations.end());
+        REQUIRE(collector.num_way_member_metas() == 2 * num_relations);
+        osmium::apply(ways, collector.handler());
+        REQUIRE(collector.num_way_member_metas() < 2 * num_relations - 2 * 10000);
+    }
+
+    SECTION("member shared by all relations comes last") {
+        for (osmium::object_id_type id = 1; id <= num_relations; ++id) {
+            buffer_add_relation(relations, "", {}, {
+                std::make_tuple('w', id, ""),
+                std::make_tuple('w', num_relations + 1, "")
+            }).set_id(id);
+        }
+        for (osmium::object_id_type id = 1; id <= num_relations + 1; ++id) {
+            buffer_add_way(ways, "", {}, std::vector<osmium::object_id_type>{id, id + 1}).set_id(id);
+        }
+
+        collector.read_relations(relations.begin(), relations.end());
+        osmium::apply(ways, collector.handler());
+        REQUIRE(collector.num_way_member_metas() == 0);
+    }
+
+    REQUIRE(collector.complete == num_relations);
+    REQUIRE(collector.members_found == 2 * num_relations);
+}
+
+TEST_CASE("Collector finds members through the member filter") {
+
+    osmium::memory::Buffer relations1(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    osmium::memory::Buffer relations2(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    for (osmium::object_id_type id = 1; id <= 500; ++id) {
+        buffer_add_relation(relations1, "", {}, {
+            std::make_tuple('w', id * 3, ""),
+            std::make_tuple('w', -id * 3, "")
+        }).set_id(id);
+        buffer_add_relation(relations2, "", {}, {
+            std::make_tuple('w', id * 3 + 1, ""),
+            std::make_tuple('w', -id * 3 - 1, "")
+        }).set_id(id + 500);
+    }
+
+    // Ways with IDs from -2000 to 2000, most of them aren't members.
+    osmium::memory::Buffer ways(1024 * 1024, osmium::memory::Buffer::auto_grow::yes);
+    for (osmium::object_id_type id = -2000; id <= 2000; ++id) {
+        if (id != 0) {
+            buffer_add_way(ways, "", {}, std::vector<osmium::object_id_type>{1, 2}).set_id(id);
+        }
+    }
+
+    TestCollector collector;
+
+    SECTION("members with negative and positive IDs") {
+        collector.read_relations(relations1.begin(), relations1.end());
+        osmium::apply(ways, collector.handler());
+        REQUIRE(collector.complete == 500);
+        REQUIRE(collector.members_found == 1000);
+    }
+
+    SECTION("filter is rebuilt when more relations are read") {
+        collector.read_relations(relations1.begin(), relations1.end());
+        collector.read_relations(relations2.begin(), relations2.end());
+        osmium::apply(ways, collector.handler());
+        REQUIRE(collector.complete == 1000);
+        REQUIRE(collector.members_found == 2000);
+    }
+
+    REQUIRE(collector.get_incomplete_relations().empty());
+}
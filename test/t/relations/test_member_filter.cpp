@@ -0,0 +1,55 @@
+#include "catch.hpp"
+
+#include <osmium/relations/detail/member_filter.hpp>
+
+TEST_CASE("Member filter") {
+
+    osmium::relations::MemberFilter filter;
+
+    SECTION("empty filter lets nothing through") {
+        filter.reset(0);
+        REQUIRE_FALSE(filter.might_contain(0));
+        REQUIRE_FALSE(filter.might_contain(17));
+    }
+
+    SECTION("no false negatives and few false positives") {
+        filter.reset(20000);
+        for (osmium::object_id_type id = 1; id <= 10000; ++id) {
+            filter.add(id * 7);
+            filter.add(-id);
+        }
+
+        for (osmium::object_id_type id = 1; id <= 10000; ++id) {
+            REQUIRE(filter.might_contain(id * 7));
+            REQUIRE(filter.might_contain(-id));
+        }
+
+        int false_positives = 0;
+        for (osmium::object_id_type id = 100000; id < 200000; ++id) {
+            if (filter.might_contain(id)) {
+                ++false_positives;
+            }
+        }
+        REQUIRE(false_positives < 3000);
+    }
+
+    SECTION("false positive rate of a full filter with more than 2^20 words") {
+        // Exactly 16 bits per ID, the fullest the filter gets.
+        const osmium::object_id_type num_ids = 4 * (1 << 21);
+        filter.reset(num_ids);
+        REQUIRE(filter.used_memory() == (1 << 21) * sizeof(uint64_t));
+
+        for (osmium::object_id_type id = 1; id <= num_ids; ++id) {
+            filter.add(id);
+        }
+
+        int false_positives = 0;
+        for (osmium::object_id_type id = num_ids + 1; id <= num_ids + 1000000; ++id) {
+            if (filter.might_contain(id)) {
+                ++false_positives;
+            }
+        }
+        REQUIRE(false_positives < 20000);
+    }
+
+}
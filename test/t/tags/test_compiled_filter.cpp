@@ -0,0 +1,169 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <osmium/builder/builder_helper.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/tags/compiled_filter.hpp>
+#include <osmium/tags/filter.hpp>
+#include <osmium/tags/taglist.hpp>
+
+static void check_filter(const osmium::TagList& tag_list, const osmium::tags::CompiledFilter& filter, const std::vector<bool>& reference) {
+    REQUIRE(tag_list.size() == reference.size());
+    auto t_it = tag_list.begin();
+    for (auto it = reference.begin(); it != reference.end(); ++t_it, ++it) {
+        REQUIRE(filter(*t_it) == *it);
+    }
+
+    osmium::tags::CompiledFilter::iterator fi_begin(filter, tag_list.begin(), tag_list.end());
+    osmium::tags::CompiledFilter::iterator fi_end(filter, tag_list.end(), tag_list.end());
+
+    REQUIRE(std::distance(fi_begin, fi_end) == std::count(reference.begin(), reference.end(), true));
+}
+
+TEST_CASE("CompiledFilter") {
+
+    osmium::memory::Buffer buffer(10240);
+
+    SECTION("matches keys") {
+        osmium::tags::CompiledFilter filter(false);
+        filter.add(true, "highway").add(true, "railway");
+        REQUIRE(filter.count() == 2);
+
+        const osmium::TagList& tag_list = osmium::builder::build_tag_list(buffer, {
+            { "highway", "primary" },
+            { "name", "Main Street" },
+            { "highways", "GPS" }
+        });
+
+        check_filter(tag_list, filter, {true, false, false});
+    }
+
+    SECTION("matches keys and values") {
+        osmium::tags::CompiledFilter filter(false);
+        filter.add(true, "highway", "residential").add(true, "highway", "primary").add(true, "railway");
+
+        const osmium::TagList& tag_list = osmium::builder::build_tag_list(buffer, {
+            { "highway", "primary" },
+            { "railway", "tram" },
+            { "source", "GPS" },
+            { "highway", "secondary" }
+        });
+
+        check_filter(tag_list, filter, {true, true, false, false});
+    }
+
+    SECTION("first matching rule wins") {
+        osmium::tags::CompiledFilter filter1(false);
+        filter1.add(true, "highway").add(false, "highway", "road");
+
+        osmium::tags::CompiledFilter filter2(false);
+        filter2.add(false, "highway", "road").add(true, "highway");
+
+        osmium::tags::CompiledFilter filter3(true);
+        filter3.add_prefix(false, "name:").add(true, "name:en", "London");
+
+        const osmium::TagList& tag_list = osmium::builder::build_tag_list(buffer, {
+            { "highway", "road" },
+            { "highway", "primary" },
+            { "name:en", "London" },
+            { "name", "London" }
+        });
+
+        check_filter(tag_list, filter1, {true, true, false, false});
+        check_filter(tag_list, filter2, {false, true, false, false});
+        check_filter(tag_list, filter3, {true, true, false, true});
+    }
+
+    SECTION("matches key prefixes") {
+        osmium::tags::CompiledFilter filter(false);
+        filter.add_prefix(true, "addr:").add_prefix(true, "name", "x").add(true, "source");
+
+        const osmium::TagList& tag_list = osmium::builder::build_tag_list(buffer, {
+            { "addr:street", "Main Street" },
+            { "addr", "yes" },
+            { "name:de", "x" },
+            { "name:en", "y" },
+            { "source", "GPS" }
+        });
+
+        check_filter(tag_list, filter, {true, false, true, false, true});
+    }
+
+    SECTION("works with match_any_of() and copies") {
+        osmium::tags::CompiledFilter filter;
+        filter.add(true, "highway", "primary").add(true, "name");
+
+        const osmium::TagList& tag_list = osmium::builder::build_tag_list(buffer, {
+            { "highway", "primary" },
+            { "railway", "tram" }
+        });
+
+        osmium::tags::CompiledFilter copy;
+        {
+            osmium::tags::CompiledFilter tmp(filter);
+            copy = tmp;
+        }
+
+        REQUIRE( osmium::tags::match_any_of(tag_list, copy));
+        REQUIRE(!osmium::tags::match_all_of(tag_list, copy));
+    }
+
+    SECTION("matches indexes into a string table") {
+        osmium::tags::CompiledFilter filter(false);
+        filter.add(false, "highway", "road").add(true, "highway").add_prefix(true, "name:", "London");
+
+        const std::vector<std::string> string_table = { "", "highway", "road", "primary", "name:en", "London" };
+        const osmium::tags::CompiledFilter::StringTableMatcher matcher(filter, string_table.begin(), string_table.end());
+        REQUIRE(matcher.size() == string_table.size());
+
+        REQUIRE_FALSE(matcher(1, 2));
+        REQUIRE(matcher(1, 3));
+        REQUIRE(matcher(4, 5));
+        REQUIRE_FALSE(matcher(4, 3));
+        REQUIRE_FALSE(matcher(2, 1));
+    }
+
+}
+
+TEST_CASE("CompiledFilter gives same results as Filter") {
+
+    const std::vector<std::string> keys = { "highway", "name", "name:en", "name:de", "railway", "source", "addr:street", "n" };
+    const std::vector<std::string> values = { "primary", "road", "London", "GPS", "yes", "" };
+
+    osmium::tags::KeyValueFilter kv_filter(false);
+    osmium::tags::KeyPrefixFilter prefix_filter(true);
+    osmium::tags::CompiledFilter compiled_kv_filter(false);
+    osmium::tags::CompiledFilter compiled_prefix_filter(true);
+
+    for (size_t i = 0; i < 20; ++i) {
+        const std::string& key = keys[(i * 7) % keys.size()];
+        const std::string& value = values[(i * 5) % values.size()];
+        if (i % 3 == 0) {
+            kv_filter.add(i % 2 == 0, key);
+            compiled_kv_filter.add(i % 2 == 0, key);
+        } else {
+            kv_filter.add(i % 2 == 0, key, value);
+            compiled_kv_filter.add(i % 2 == 0, key, value);
+        }
+        const std::string prefix = key.substr(0, i % 5);
+        prefix_filter.add(i % 2 == 1, prefix);
+        compiled_prefix_filter.add_prefix(i % 2 == 1, prefix);
+    }
+
+    osmium::memory::Buffer buffer(10240);
+    for (const auto& key : keys) {
+        for (const auto& value : values) {
+            const osmium::TagList& tag_list = osmium::builder::build_tag_list(buffer, {
+                { key.c_str(), value.c_str() }
+            });
+            const osmium::Tag& tag = *tag_list.begin();
+            REQUIRE(kv_filter(tag) == compiled_kv_filter(tag));
+            REQUIRE(prefix_filter(tag) == compiled_prefix_filter(tag));
+        }
+    }
+
+}
@@ -62,6 +62,14 @@ TEST_CASE("thread") {
         REQUIRE(future.get() == 42);
     }
 
+    SECTION("knows its worker threads") {
+        REQUIRE_FALSE(pool.is_worker_thread());
+        auto future = pool.submit([&pool] {
+            return pool.is_worker_thread();
+        });
+        REQUIRE(future.get());
+    }
+
     SECTION("can throw from job in thread pool") {
         auto future = pool.submit(test_job_throw {});
 
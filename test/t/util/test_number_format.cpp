@@ -0,0 +1,61 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include <osmium/util/number_format.hpp>
+
+TEST_CASE("Number format") {
+
+    SECTION("append_int") {
+        std::string s;
+        osmium::util::append_int(s, 0);
+        REQUIRE(s == "0");
+
+        s.clear();
+        osmium::util::append_int(s, -17);
+        REQUIRE(s == "-17");
+
+        s.clear();
+        osmium::util::append_int(s, std::numeric_limits<int64_t>::min());
+        REQUIRE(s == "-9223372036854775808");
+
+        s.clear();
+        osmium::util::append_int(s, std::numeric_limits<uint64_t>::max());
+        REQUIRE(s == "18446744073709551615");
+    }
+
+    SECTION("append_int_with_width") {
+        std::string s;
+        osmium::util::append_int(s, 42, 5);
+        REQUIRE(s == "   42");
+
+        s.clear();
+        osmium::util::append_int(s, -42, 5, '0');
+        REQUIRE(s == "-0042");
+
+        s.clear();
+        osmium::util::append_int(s, 123456, 3);
+        REQUIRE(s == "123456");
+    }
+
+    SECTION("append_fixed_point") {
+        std::string s;
+        osmium::util::append_fixed_point(s, 0, 7);
+        REQUIRE(s == "0.0000000");
+
+        s.clear();
+        osmium::util::append_fixed_point(s, 1234567890, 7);
+        REQUIRE(s == "123.4567890");
+
+        s.clear();
+        osmium::util::append_fixed_point(s, -5, 7);
+        REQUIRE(s == "-0.0000005");
+
+        s.clear();
+        osmium::util::append_fixed_point(s, -5, 0);
+        REQUIRE(s == "-5");
+    }
+
+}